@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+#
+# Profile-guided and link-time optimized build of the bundle
+#
+# 1. reference build, tick driver timing
+# 2. instrumented build, the tick driver runs the training workload and writes the profiles
+# 3. optimized build with -fprofile-use and LTO, installed into generated/ like the regular build
+# 4. timing of the optimized build, the per-tick speedup is written to generated/<platform>/pgo-report.txt
+#
+# usage: build-pgo.sh [amd64|arm64]
+#
+# The arm64 tick driver runs in qemu user emulation by default, the speedup reported for it is therefore
+# only indicative. Set PGO_RUNNER to run it differently, e.g. on a target via a wrapper script.
+#
+set -e
+ARCH=${1:-amd64}
+TICKS=${PGO_TICKS:-200000}
+if [ "${ARCH}" == "arm64" ]; then
+  BUILD_KIT=aarch64-linux-gnu
+  TARGET_PLATFORM=ubuntu22-gcc-aarch64
+  RUNNER=${PGO_RUNNER-"qemu-aarch64 -L /usr/aarch64-linux-gnu"}
+else
+  BUILD_KIT=x86_64-linux-gnu
+  TARGET_PLATFORM=ubuntu22-gcc-x64
+  RUNNER=${PGO_RUNNER-}
+fi
+PROFILE_DIR=${PWD}/generated/pgo/${TARGET_PLATFORM}
+REPORT=${PWD}/generated/${TARGET_PLATFORM}/pgo-report.txt
+
+build() {
+  rm -rf build-pgo-$1/
+  cmake -S . -B build-pgo-$1 \
+    -DBUILD_KIT=${BUILD_KIT} \
+    -DCMAKE_BUILD_TYPE=RelWithDebInfo \
+    -DBUILD_TICK_DRIVER=ON \
+    -DPGO_MODE=$2 \
+    -DPGO_PROFILE_DIR=${PROFILE_DIR}
+  cmake --build build-pgo-$1 -j"$(nproc)"
+}
+
+run_driver() {
+  LD_LIBRARY_PATH=build-pgo-$1/source/impl ${RUNNER} build-pgo-$1/source/driver/tick_driver --ticks ${TICKS}
+}
+
+rm -rf generated/
+rm -rf ${PROFILE_DIR}
+
+build reference ""
+REFERENCE=$(run_driver reference)
+
+build instrumented generate
+run_driver instrumented
+
+build optimized use
+OPTIMIZED=$(run_driver optimized)
+cmake --install build-pgo-optimized
+
+mean() { echo "$1" | sed -n 's/.*mean_ns=\([0-9.]*\).*/\1/p'; }
+mkdir -p $(dirname ${REPORT})
+{
+  echo "platform:  ${TARGET_PLATFORM}"
+  echo "runner:    ${RUNNER:-native}"
+  echo "reference: ${REFERENCE}"
+  echo "optimized: ${OPTIMIZED}"
+  awk -v r=$(mean "${REFERENCE}") -v o=$(mean "${OPTIMIZED}") 'BEGIN { printf "speedup:   %.2fx per tick\n", r/o }'
+} | tee ${REPORT}
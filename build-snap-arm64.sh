@@ -1,5 +1,18 @@
 #!/usr/bin/env bash
+#
+# usage: build-snap-arm64.sh [PGO profile directory]
+#
+# With a profile directory, e.g. generated/pgo/<platform> written by build-pgo.sh, the libraries are built
+# profile-guided and link-time optimized (-DPGO_MODE=use). The profiles are copied first, generated/ is cleared.
+#
 set -e
+PGO_OPTIONS=""
+if [ -n "$1" ]; then
+  PROFILE_DIR=$(mktemp -d)
+  trap 'rm -rf ${PROFILE_DIR}' EXIT
+  cp -r "$1"/. ${PROFILE_DIR}
+  PGO_OPTIONS="-DPGO_MODE=use -DPGO_PROFILE_DIR=${PROFILE_DIR}"
+fi
 rm -rf bfbs/
 rm -rf generated/
 rm -rf build/
@@ -8,6 +21,7 @@ pushd build
 cmake \
     -DBUILD_KIT=aarch64-linux-gnu \
     -DCMAKE_BUILD_TYPE=RelWithDebInfo \
+    ${PGO_OPTIONS} \
     ..
 make install
 popd
@@ -1,29 +1,128 @@
 #include "EtherCATUpdates.h"
 #include "../impl/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 
-long int m_ticks = 0;    
-int16_t DigitalOutputs = 0xFF;
+Example::RetainedState<LogicState> retained;
 Drive axis1;
+//state set by operator commands
+struct Operator
+{
+    bool Enable = true;
+    bool Halt = false;
+    bool SecondaryOpMode = true;
+} operator1;
+Example::AnalogConverter* analog = nullptr;
+Example::StaticVector<int, 64> analogInputs; //channels of the analog input modules, see Analog
+const float CycleTime = 0.001f; //cycle time of the task in s
+Example::VelocityObserverBank velocityObserver; //actual velocity derived from ActPosition
+Example::TimerWheel* timers = nullptr; //output writes at future ticks, see Timers
+const uint64_t PulseTicks = 37; //length of the pulse on DO_16_1/Channel_2 when the drive reaches AF
+Example::TimedWrite pulseOn; //pulse on and off, resolved in Timers
+Example::TimedWrite pulseOff;
+
+//name, offset, type, minimum, maximum of the parameters that can be edited
+Example::ParameterStore<LogicParameters> parameters({
+    {"Axis1/Velocity", offsetof(LogicParameters, Velocity), Example::SignalType::Int32, -8000000, 8000000},
+    {"DO_16_1/TogglePeriod", offsetof(LogicParameters, TogglePeriod), Example::SignalType::UInt32, 1, 1000000},
+    {"Axis1/Acceleration", offsetof(LogicParameters, Acceleration), Example::SignalType::Float32, 0, 1e9},
+});
+
+//turn on/off some outputs just to show how it is done
+Example::Sequence blinkOutputs()
+{
+    while(true)
+    {
+        co_await Example::delay(parameters.get().TogglePeriod);
+        retained.get().DigitalOutputs = retained.get().DigitalOutputs ^ 0xFFFF;
+    }
+}
+
+//reports a drive that does not follow the enable
+Example::Sequence watchEnable()
+{
+    while(true)
+    {
+        co_await Example::until([]{ return operator1.Enable && (axis1.StatusWord & ST_DriveInAb) != 0 && (axis1.StatusWord & ST_DriveError) == 0; });
+        if(!co_await Example::until([]{ return (axis1.StatusWord & ST_DriveInAF) == ST_DriveInAF; }, static_cast<uint64_t>(2.0f/CycleTime)))
+        {
+            LOG_WARNING("Axis1 is not in AF 2 s after the enable");
+        }
+        co_await Example::until([]{ return !operator1.Enable || (axis1.StatusWord & ST_DriveInAF) != ST_DriveInAF; });
+    }
+}
+
+void LogicParameters::derive()
+{
+    //runs in the non real-time code that publishes the set
+    VelocityStep = Acceleration > 0.0f ? static_cast<int32_t>(std::max(1.0f, std::round(Acceleration*CycleTime))) : INT32_MAX;
+}
+
+//byte offsets of the bound variables in the process image, resolved once in Bind
+struct Binding
+{
+    uint32_t DigitalOutputs;
+    uint32_t ControlWord;
+    uint32_t VelocityCommand;
+    uint32_t StatusWord;
+    uint32_t ActPosition;
+    bool Valid = false;
+} binding;
 
 namespace EtherCATUpdate{
-    void MDT(u_int8_t* outData, std::map<std::string,uint32_t> m_outMap)
+    std::vector<Example::RealtimeSourceAddress> Sources()
+    {
+        //every entry is a realtime_data memory pair, e.g. a second master with the prefix "Master2/" for its variable names
+        return {
+            {"fieldbuses/ethercat/master/instances/ethercatmaster/realtime_data", ""},
+        };
+    }
+
+    void Bind(Example::ProcessImage& image)
     {
-        m_ticks++; 
+        auto digitalOutputs = image.output("DO_16_1/Channel_1.Value");
+        auto controlWord = image.output("Axis1/MDT.Master_control_word");
+        auto velocityCommand = image.output("Axis1/MDT.VelocityCommand");
+        auto statusWord = image.input("Axis1/AT.Drive_status_word");
+        auto actPosition = image.input("Axis1/AT.Position_feedback_value_1");
+        binding.Valid = digitalOutputs && controlWord && velocityCommand && statusWord && actPosition;
+        if(!binding.Valid)
+        {
+            LOG_WARNING("Not all variables of Axis1 and DO_16_1 are available, the example logic is disabled");
+            return;
+        }
+        binding.DigitalOutputs = digitalOutputs->byteOffset();
+        binding.ControlWord = controlWord->byteOffset();
+        binding.VelocityCommand = velocityCommand->byteOffset();
+        binding.StatusWord = statusWord->byteOffset();
+        binding.ActPosition = actPosition->byteOffset();
+        velocityObserver.clear();
+        velocityObserver.add(300.0f, CycleTime);
+    }
 
-        //turn on/off some outputs just to show how it is done
-        if(0 == m_ticks%500)
+    void MDT(u_int8_t* outData)
+    {
+        if(!binding.Valid)
         {
-            DigitalOutputs = DigitalOutputs ^ 0xFFFF;
+            return;
         }
+        //the newest parameter set, taken over by the application at the start of the tick
+        const LogicParameters& set = parameters.get();
+
         //Enable the only drive  
         //Check to see if the drive is in Ab and Error free
         LOG_INFO("Ab State: %i", axis1.StatusWord & ST_DriveInAb);             
         LOG_INFO("Erorr State: %i", axis1.StatusWord & ST_DriveError);             
-        if (((axis1.StatusWord & ST_DriveInAb) != 0) && ((axis1.StatusWord & ST_DriveError) == 0)) 
+        if (((axis1.StatusWord & ST_DriveInAb) != 0) && ((axis1.StatusWord & ST_DriveError) == 0) && operator1.Enable) 
         {
             axis1.ControlWord = axis1.ControlWord | (CMD_DriveEnable | CMD_DriveHALT | CMD_DriveON); //Enable bits 15,14,13 to enable (0xE000). 
+            if(operator1.Halt)
+            {
+                axis1.ControlWord = axis1.ControlWord & ~CMD_DriveHALT; //the halt bit is active low
+            }
             axis1.ControlWord = (axis1.ControlWord & CMD_ClearOpMode); //Reset the operation mode
-            axis1.ControlWord = (axis1.ControlWord | CMD_SecondaryOpMode); //Set the secondary operation mode            
+            axis1.ControlWord = (axis1.ControlWord | (operator1.SecondaryOpMode ? CMD_SecondaryOpMode : CMD_PrimaryOpMode)); //Set the operation mode            
         }
         else
         {   //if there is an error or if the drive is not ready then clear the control bits
@@ -31,22 +130,181 @@ namespace EtherCATUpdate{
         }
         axis1.ControlWord = axis1.ControlWord ^ CMD_CommsToggle; //toggle the control bit, the 10th bit in the control word
         //copy over the IO
-        std::memcpy(&outData[m_outMap["DO_16_1/Channel_1.Value"]/8], &DigitalOutputs, 2); 
+        std::memcpy(&outData[binding.DigitalOutputs], &retained.get().DigitalOutputs, 2); 
         //copy over the control word
         LOG_INFO("Control Word: %i", axis1.ControlWord);  
-        std::memcpy(&outData[m_outMap["Axis1/MDT.Master_control_word"]/8], &axis1.ControlWord, 2); 
+        std::memcpy(&outData[binding.ControlWord], &axis1.ControlWord, 2); 
         //copy over the velocity commands
-        //int32_t Velocity = 300000;
-        axis1.CMDVelocity = 300000;
-        std::memcpy(&outData[m_outMap["Axis1/MDT.VelocityCommand"]/8], &axis1.CMDVelocity, 4);
+        //ramp to the velocity of the parameter set
+        int64_t change = std::clamp<int64_t>(int64_t(set.Velocity) - axis1.CMDVelocity, -set.VelocityStep, set.VelocityStep);
+        axis1.CMDVelocity = static_cast<int32_t>(axis1.CMDVelocity + change);
+        std::memcpy(&outData[binding.VelocityCommand], &axis1.CMDVelocity, 4);
     }
 
-    void AT(u_int8_t* inData, std::map<std::string,uint32_t> m_inMap)
+    void AT(const u_int8_t* inData)
     {
+        if(!binding.Valid)
+        {
+            return;
+        }
         LOG_INFO("Writing"); 
         //Read in the status word
-        axis1.StatusWord = *(int16_t*)(&inData[m_inMap["Axis1/AT.Drive_status_word"]/8]);         
-        axis1.ActPosition = *(int32_t*)(&inData[m_inMap["Axis1/AT.Position_feedback_value_1"]/8]);         
+        std::memcpy(&axis1.StatusWord, &inData[binding.StatusWord], 2);         
+        std::memcpy(&axis1.ActPosition, &inData[binding.ActPosition], 4);         
+        //a section of its own in the execution timeline, SDK_EXAMPLE_TIMELINE
+        {
+            Example::TimelineScope scope("velocity observer");
+            velocityObserver.setInput(0, axis1.ActPosition);
+            velocityObserver.update();
+            axis1.ActVelocity = static_cast<int32_t>(velocityObserver.velocity(0));
+        }
+        //counters kept over restarts
+        LogicState& state = retained.get();
+        bool inAF = (axis1.StatusWord & ST_DriveInAF) == ST_DriveInAF;
+        if(inAF && !state.InAF && timers && pulseOn.size)
+        {
+            //the pulse starts in this tick and ends PulseTicks ticks later
+            timers->schedule(0, pulseOn);
+            timers->schedule(PulseTicks, pulseOff);
+        }
+        if(inAF)
+        {
+            state.Enables += state.InAF ? 0 : 1;
+            state.EnabledTicks++;
+        }
+        state.InAF = inAF;
         LOG_INFO("Status Word: %i, Actual Position: %i", axis1.StatusWord, axis1.ActPosition); 
     }
+
+    void Telemetry(Example::TelemetryAggregator& telemetry, Example::ProcessImage& image)
+    {
+        //statistics over windows of 100 ticks
+        telemetry.setWindow(100);
+        auto position = image.input("Axis1/AT.Position_feedback_value_1");
+        if(position)
+        {
+            telemetry.addChannel("Axis1/ActPosition", Example::SignalRef::image(position->bitOffset, Example::SignalType::Int32));
+        }
+        telemetry.addChannel("Axis1/CMDVelocity", Example::SignalRef::variable(&axis1.CMDVelocity, Example::SignalType::Int32));
+    }
+
+    void Scope(Example::Oscilloscope& scope, Example::ProcessImage& image)
+    {
+        //record 500 ticks before and 1500 ticks after the drive reports an error
+        scope.setDepth(500, 1500);
+        auto statusWord = image.input("Axis1/AT.Drive_status_word");
+        auto position = image.input("Axis1/AT.Position_feedback_value_1");
+        //outputs are only looked up, binding them with image.output() would write them back every tick
+        auto controlWord = image.outputMap().find("Axis1/MDT.Master_control_word");
+        auto velocity = image.outputMap().find("Axis1/MDT.VelocityCommand");
+        if(!statusWord)
+        {
+            return;
+        }
+        scope.addChannel("Axis1/StatusWord", Example::ScopeImage::Input, Example::SignalRef::image(statusWord->bitOffset, Example::SignalType::UInt16));
+        if(position)
+        {
+            scope.addChannel("Axis1/ActPosition", Example::ScopeImage::Input, Example::SignalRef::image(position->bitOffset, Example::SignalType::Int32));
+        }
+        if(controlWord != image.outputMap().end())
+        {
+            scope.addChannel("Axis1/ControlWord", Example::ScopeImage::Output, Example::SignalRef::image(controlWord->second.bitOffset, Example::SignalType::UInt16));
+        }
+        if(velocity != image.outputMap().end())
+        {
+            scope.addChannel("Axis1/CMDVelocity", Example::ScopeImage::Output, Example::SignalRef::image(velocity->second.bitOffset, Example::SignalType::Int32));
+        }
+        scope.setTrigger(Example::ScopeImage::Input, Example::SignalRef::image(statusWord->bitOffset, Example::SignalType::UInt16), Example::ScopeTrigger::BitSet, 0, ST_DriveError);
+        scope.arm();
+    }
+
+    void Analog(Example::AnalogConverter& converter, Example::ProcessImage& image)
+    {
+        //scale the channels of all analog input modules to +-10V, use analog->input(channel) in AT/MDT
+        analog = &converter;
+        analogInputs.clear();
+        for(auto& variable : image.inputMap())
+        {
+            if(variable.first.rfind("AI_", 0) == 0 && variable.first.find(".Value") != std::string_view::npos)
+            {
+                //channels beyond the capacity are not bound, so they are not copied either
+                if(analogInputs.full())
+                {
+                    break;
+                }
+                image.input(variable.first);
+                analogInputs.push_back(converter.addInput(variable.first, variable.second.bitOffset, 10.0f/32767.0f, 0.0f, -10.0f, 10.0f));
+            }
+        }
+    }
+
+    void Timers(Example::TimerWheel& wheel, Example::ProcessImage& image)
+    {
+        //room for the pending writes of all tick-precise outputs
+        wheel.resize(1024);
+        timers = &wheel;
+        pulseOn = pulseOff = Example::TimedWrite();
+        auto pulse = image.output("DO_16_1/Channel_2.Value");
+        if(pulse)
+        {
+            pulseOn = Example::TimedWrite::set(*pulse, 0xFFFF);
+            pulseOff = Example::TimedWrite::set(*pulse, 0);
+        }
+    }
+
+    void Export(Example::ImageExporter& exporter, Example::ProcessImage& image)
+    {
+        //axis state for local processes, the input and output images are exported as a whole
+        exporter.addValue("Axis1/StatusWord", Example::SignalRef::variable(&axis1.StatusWord, Example::SignalType::UInt16));
+        exporter.addValue("Axis1/ControlWord", Example::SignalRef::variable(&axis1.ControlWord, Example::SignalType::UInt16));
+        exporter.addValue("Axis1/ActPosition", Example::SignalRef::variable(&axis1.ActPosition, Example::SignalType::Int32));
+        exporter.addValue("Axis1/ActVelocity", Example::SignalRef::variable(&axis1.ActVelocity, Example::SignalType::Int32));
+        exporter.addValue("Axis1/CMDVelocity", Example::SignalRef::variable(&axis1.CMDVelocity, Example::SignalType::Int32));
+    }
+
+    void Publish(Example::RealtimePublisher& publisher, Example::ProcessImage& image)
+    {
+        //filtered feedback and setpoints for other RT apps, e.g. the PLC reads sdk-example-rt/realtime_data/input
+        publisher.addValue("Axis1/ActVelocity", Example::SignalRef::variable(&axis1.ActVelocity, Example::SignalType::Int32));
+        publisher.addValue("Axis1/CMDVelocity", Example::SignalRef::variable(&axis1.CMDVelocity, Example::SignalType::Int32));
+        publisher.addValue("Axis1/ControlWord", Example::SignalRef::variable(&axis1.ControlWord, Example::SignalType::UInt16));
+        publisher.addValue("Axis1/StatusWord", Example::SignalRef::variable(&axis1.StatusWord, Example::SignalType::UInt16));
+    }
+
+    Example::IParameterStore* Parameters()
+    {
+        return &parameters;
+    }
+
+    Example::IRetainedState* Retained()
+    {
+        return &retained;
+    }
+
+    Example::CommandResult Command(const Example::Command& command)
+    {
+        //runs at the start of the tick, before AT and MDT
+        if(command.target != 1)
+        {
+            return {COMMAND_INVALID_TARGET, 0};
+        }
+        switch(command.code)
+        {
+            case COMMAND_ENABLE: operator1.Enable = command.argument != 0; break;
+            case COMMAND_HALT: operator1.Halt = command.argument != 0; break;
+            case COMMAND_OPERATION_MODE: operator1.SecondaryOpMode = command.argument != 0; break;
+            default: return {COMMAND_UNKNOWN, 0};
+        }
+        return {COMMAND_DONE, axis1.StatusWord};
+    }
+
+    void Sequences(Example::Sequencer& sequencer)
+    {
+        if(!binding.Valid)
+        {
+            return;
+        }
+        sequencer.start(blinkOutputs());
+        sequencer.start(watchEnable());
+    }
 }
@@ -1,10 +1,36 @@
-#include <map> 
+#include <cstdint>
 #include "comm/datalayer/datalayer.h"
+#include "../impl/rt_process_image.h"
+#include "../impl/rt_telemetry.h"
+#include "../impl/rt_scope.h"
+#include "../impl/rt_analog.h"
+#include "../impl/rt_control.h"
+#include "../impl/rt_export.h"
+#include "../impl/rt_publisher.h"
+#include "../impl/rt_parameters.h"
+#include "../impl/rt_retained.h"
+#include "../impl/rt_commands.h"
+#include "../impl/rt_sequencer.h"
+#include "../impl/rt_containers.h"
+#include "../impl/rt_timeline.h"
+#include "../impl/rt_timer_wheel.h"
 
 namespace EtherCATUpdate
             {
-            void MDT(u_int8_t* outData, std::map<std::string,uint32_t> m_outMap);
-            void AT(u_int8_t* inData, std::map<std::string,uint32_t> m_inMap);            
+            std::vector<Example::RealtimeSourceAddress> Sources();
+            void Bind(Example::ProcessImage& image);
+            void MDT(u_int8_t* outData);
+            void AT(const u_int8_t* inData);            
+            void Telemetry(Example::TelemetryAggregator& telemetry, Example::ProcessImage& image);
+            void Scope(Example::Oscilloscope& scope, Example::ProcessImage& image);
+            void Analog(Example::AnalogConverter& analog, Example::ProcessImage& image);
+            void Timers(Example::TimerWheel& timers, Example::ProcessImage& image);
+            void Export(Example::ImageExporter& exporter, Example::ProcessImage& image);
+            void Publish(Example::RealtimePublisher& publisher, Example::ProcessImage& image);
+            Example::IParameterStore* Parameters();
+            Example::IRetainedState* Retained();
+            Example::CommandResult Command(const Example::Command& command);
+            void Sequences(Example::Sequencer& sequencer);
             }
 class Drive 
     {
@@ -17,6 +43,27 @@ class Drive
         int32_t ActPosition;
     };
 
+//parameters of the example logic, edited in $SNAP_COMMON/parameters.txt or the file SDK_EXAMPLE_PARAMETERS
+struct LogicParameters
+    {
+    int32_t Velocity = 300000; //velocity command in drive units
+    uint32_t TogglePeriod = 500; //ticks between two changes of the digital outputs
+    float Acceleration = 0.0f; //ramp of the velocity command in drive units/s, 0 = no ramp
+    //derived when the set is published, not edited
+    int32_t VelocityStep = INT32_MAX; //change of the velocity command per tick
+    void derive();
+    };
+
+//state of the example logic that survives a restart, kept in $SNAP_COMMON/retained.bin or the file SDK_EXAMPLE_RETAINED
+struct LogicState
+    {
+    static constexpr uint32_t VERSION = 1; //increase when the layout changes
+    int16_t DigitalOutputs = 0xFF; //pattern of the digital outputs
+    bool InAF = false; //drive was in AF in the last tick
+    uint32_t Enables = 0; //number of times the drive went to AF
+    uint64_t EnabledTicks = 0; //ticks the drive was in AF
+    };
+
 //control word constants
 const uint16_t CMD_DriveON = 0x8000; //Drive on
 const uint16_t CMD_DriveEnable = 0x4000; //Drive enable
@@ -26,6 +73,15 @@ const uint16_t CMD_ClearOpMode = 0xF4FF; //Bitwise AND with the control word
 const uint16_t CMD_PrimaryOpMode = 0x0000; //Bitwise OR with the control word after reset
 const uint16_t CMD_SecondaryOpMode = 0x0100; //Bitwise OR with the control word after reset
 
+//operator commands, see EtherCATUpdate::Command; the target is the axis number
+const uint32_t COMMAND_ENABLE = 1; //argument 1: enable the drive once it is ready, 0: disable it
+const uint32_t COMMAND_HALT = 2; //argument 1: halt the drive, 0: release it
+const uint32_t COMMAND_OPERATION_MODE = 3; //argument 0: primary, 1: secondary operation mode
+//command results
+const int32_t COMMAND_DONE = 0;
+const int32_t COMMAND_UNKNOWN = -1;
+const int32_t COMMAND_INVALID_TARGET = -2;
+
 //status word constants
 const uint16_t ST_DriveInAF = 0xC000; //Drive is in the AF state
 const uint16_t ST_DriveInAb = 0x8000; //Drive is in the Ab State
@@ -2,15 +2,45 @@
 #include "common/log/trace/defs.h"
 #include "common/log/trace/log_buffered3.h"
 #include "../impl/Logger.h"
+#include <cstdlib>
+#include <string>
 void ExampleComponent::init(){
 }
 void ExampleComponent::start(){
+  //locks memory, holds the wakeup latency and checks the system before the first tick, SDK_EXAMPLE_PREFLIGHT=off skips it
+  const char* preflight = std::getenv("SDK_EXAMPLE_PREFLIGHT"); 
+  if(!preflight || std::string(preflight) != "off")
+  {
+    //SDK_EXAMPLE_DMA_LATENCY in us, default 0, "off" leaves it to the system; SDK_EXAMPLE_HEAP_RESERVE in MiB, default 32
+    const char* latency = std::getenv("SDK_EXAMPLE_DMA_LATENCY"); 
+    const char* reserve = std::getenv("SDK_EXAMPLE_HEAP_RESERVE"); 
+    int32_t latencyUs = !latency ? 0 : std::string(latency) == "off" ? -1 : std::atoi(latency); 
+    size_t reserveBytes = size_t(reserve ? std::strtoul(reserve, nullptr, 10) : 32) << 20; 
+    size_t problems = m_preflight.run(latencyUs, reserveBytes); 
+    if(problems)
+    {
+      LOG_WARNING("Preflight found %zu problems, the first ticks and the steady state may show higher jitter", problems); 
+    }
+  }
+  //background threads on the cores not isolated for real-time, e.g. SDK_EXAMPLE_WORKER_CORES=0-1
+  const char* cores = std::getenv("SDK_EXAMPLE_WORKER_CORES"); 
+  bool workers = m_workers.start(cores ? Example::WorkerPool::parseCores(cores) : std::vector<int>{}); 
+  if(!workers)
+  {
+    LOG_ERROR("Worker pool not started, the tick posts no background work"); 
+  }
+  m_appFactory->setWorkerPool(workers ? &m_workers : nullptr); 
   m_appFactory->setDataLayer(m_dataLayer); 
   m_schedular->registerCallableFactory(m_appFactory, "Example RT App"); 
 }
 void ExampleComponent::stop() {
-  m_appFactory->resetDataLayer(); 
+  //the scheduler stops calling the callable first; the memory is released after the last tick in any case, see RTApplication::quiesce
   m_schedular->unregisterCallableFactory(m_appFactory, true); 
+  //unbinding drains the work the ticks posted before it frees anything, so the pool stops afterwards
+  m_appFactory->resetDataLayer(); 
+  m_appFactory->setWorkerPool(nullptr); 
+  m_workers.stop(); 
+  m_preflight.release(); 
 }
 void ExampleComponent::deInit(){
       std::cout<<"deInit" << std::endl; 
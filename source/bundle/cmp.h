@@ -6,6 +6,8 @@
 #include "../common.log.trace/trace_itf_wrapper.h"
 #include "Trace.h"
 #include "../impl/rt_applicationFactory.h"
+#include "../impl/worker_pool.h"
+#include "../impl/rt_preflight.h"
 class ExampleComponent
 {
   public:
@@ -25,4 +27,6 @@ class ExampleComponent
     common::scheduler::IScheduler3* m_schedular; 
     //common::log::trace::IRegistrationRealTime3* m_log; 
     std::shared_ptr<Example::RTApplicationFactory> m_appFactory = std::make_shared<Example::RTApplicationFactory>();
+    Example::WorkerPool m_workers; 
+    Example::RtPreflight m_preflight; 
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include "comm/datalayer/datalayer.h"
+#include <vector>
+
+namespace Example{
+  // In-process stand-in for a realtime_data memory of the EtherCAT master
+  class HostMemory:public comm::datalayer::IMemoryUser
+  {
+    public:
+      HostMemory(size_t size, uint32_t revision, comm::datalayer::MemoryType type)
+        : m_data(size, 0), m_revision(revision), m_type(type) {}
+
+      comm::datalayer::DlResult beginAccess(uint8_t*& data, uint32_t revision) override{
+        if(revision != m_revision)
+          return comm::datalayer::DlResult::DL_RT_WRONGREVISON;
+        data = m_data.data();
+        return comm::datalayer::DlResult::DL_OK;
+      }
+      comm::datalayer::DlResult endAccess() override{
+        return comm::datalayer::DlResult::DL_OK;
+      }
+      comm::datalayer::DlResult getType(comm::datalayer::MemoryType& type) override{
+        type = m_type;
+        return comm::datalayer::DlResult::DL_OK;
+      }
+      comm::datalayer::DlResult getSize(size_t& size) override{
+        size = m_data.size();
+        return comm::datalayer::DlResult::DL_OK;
+      }
+
+      uint8_t* data() { return m_data.data(); }
+      size_t size() const { return m_data.size(); }
+
+    private:
+      std::vector<uint8_t> m_data;
+      uint32_t m_revision;
+      comm::datalayer::MemoryType m_type;
+  };
+
+  // In-process stand-in for a realtime_data memory this app creates and owns
+  class HostOwnedMemory:public comm::datalayer::IMemoryOwner
+  {
+    public:
+      HostOwnedMemory(size_t size, comm::datalayer::MemoryType type)
+        : m_data(size, 0), m_type(type) {}
+
+      comm::datalayer::DlResult beginAccess(uint8_t*& data, uint32_t revision) override{
+        data = m_data.data();
+        return comm::datalayer::DlResult::DL_OK;
+      }
+      comm::datalayer::DlResult endAccess() override{
+        return comm::datalayer::DlResult::DL_OK;
+      }
+      comm::datalayer::DlResult getType(comm::datalayer::MemoryType& type) override{
+        type = m_type;
+        return comm::datalayer::DlResult::DL_OK;
+      }
+      comm::datalayer::DlResult getSize(size_t& size) override{
+        size = m_data.size();
+        return comm::datalayer::DlResult::DL_OK;
+      }
+      comm::datalayer::DlResult setMap(const comm::datalayer::Variant& map) override{
+        m_maps++;
+        return comm::datalayer::DlResult::DL_OK;
+      }
+
+      const uint8_t* data() const { return m_data.data(); }
+      uint32_t maps() const { return m_maps; }
+
+    private:
+      std::vector<uint8_t> m_data;
+      comm::datalayer::MemoryType m_type;
+      uint32_t m_maps = 0;
+  };
+}
@@ -0,0 +1,171 @@
+#include "plant_simulator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Example{
+namespace {
+  constexpr uint32_t PLANT_REVISION = 1;
+
+  template<typename T>
+  T load(const uint8_t* data, uint32_t offset){
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+  }
+
+  template<typename T>
+  void store(uint8_t* data, uint32_t offset, T value){
+    std::memcpy(data + offset, &value, sizeof(T));
+  }
+}
+
+PlantSimulator::PlantSimulator(const PlantConfiguration& configuration)
+  : m_configuration(configuration),
+    m_state(configuration.drives, PowerUp),
+    m_timer(configuration.drives, configuration.powerUpTicks),
+    m_toggle(configuration.drives, 0),
+    m_velocity(configuration.drives, 0.0),
+    m_position(configuration.drives, 0.0)
+{
+  layout();
+}
+
+void PlantSimulator::layout(){
+  // slaves in bus order, the drives first, then the digital and the analog modules
+  uint32_t drives = m_configuration.drives;
+  m_digitalInputs = drives*DRIVE_INPUTS;
+  m_digitalOutputs = drives*DRIVE_OUTPUTS;
+  m_analogInputs = m_digitalInputs + m_configuration.digitalModules*DIGITAL_BYTES;
+  m_analogOutputs = m_digitalOutputs + m_configuration.digitalModules*DIGITAL_BYTES;
+  size_t inputSize = m_analogInputs + m_configuration.analogModules*ANALOG_BYTES;
+  size_t outputSize = m_analogOutputs + m_configuration.analogModules*ANALOG_BYTES;
+  m_inputs = std::make_shared<HostMemory>(std::max<size_t>(inputSize, 1), PLANT_REVISION, comm::datalayer::MemoryType_Input);
+  m_outputs = std::make_shared<HostMemory>(std::max<size_t>(outputSize, 1), PLANT_REVISION, comm::datalayer::MemoryType_Output);
+
+  m_inputMap.reserve(drives*3 + m_configuration.digitalModules*2 + m_configuration.analogModules);
+  m_outputMap.reserve(drives*2 + m_configuration.digitalModules*2 + m_configuration.analogModules);
+  for(uint32_t drive = 0; drive < drives; drive++){
+    std::string axis = "Axis" + std::to_string(drive + 1);
+    uint32_t in = drive*DRIVE_INPUTS*8;
+    uint32_t out = drive*DRIVE_OUTPUTS*8;
+    m_inputMap.insert(axis + "/AT.Drive_status_word", ImageVariable{in, 16});
+    m_inputMap.insert(axis + "/AT.Position_feedback_value_1", ImageVariable{in + 16, 32});
+    m_inputMap.insert(axis + "/AT.Velocity_feedback_value", ImageVariable{in + 48, 32});
+    m_outputMap.insert(axis + "/MDT.Master_control_word", ImageVariable{out, 16});
+    m_outputMap.insert(axis + "/MDT.VelocityCommand", ImageVariable{out + 16, 32});
+  }
+  for(uint32_t module = 0; module < m_configuration.digitalModules; module++){
+    std::string number = std::to_string(module + 1);
+    for(uint32_t channel = 0; channel < 2; channel++){
+      std::string name = "/Channel_" + std::to_string(channel + 1) + ".Value";
+      m_inputMap.insert("DI_16_" + number + name, ImageVariable{(m_digitalInputs + module*DIGITAL_BYTES + channel*2)*8, 16});
+      m_outputMap.insert("DO_16_" + number + name, ImageVariable{(m_digitalOutputs + module*DIGITAL_BYTES + channel*2)*8, 16});
+    }
+  }
+  for(uint32_t module = 0; module < m_configuration.analogModules; module++){
+    std::string number = std::to_string(module + 1);
+    m_inputMap.insert("AI_" + number + "/Channel_1.Value", ImageVariable{(m_analogInputs + module*ANALOG_BYTES)*8, 16});
+    m_outputMap.insert("AO_" + number + "/Channel_1.Value", ImageVariable{(m_analogOutputs + module*ANALOG_BYTES)*8, 16});
+  }
+  m_inputMap.sort();
+  m_outputMap.sort();
+}
+
+RealtimeSource PlantSimulator::source(const std::string& prefix) const{
+  RealtimeSource source;
+  source.prefix = prefix;
+  source.inputs = m_inputs;
+  source.inputMap = m_inputMap;
+  source.inputRevision = PLANT_REVISION;
+  source.outputs = m_outputs;
+  source.outputMap = m_outputMap;
+  source.outputRevision = PLANT_REVISION;
+  return source;
+}
+
+void PlantSimulator::step(){
+  const uint8_t* outData = m_outputs->data();
+  uint8_t* inData = m_inputs->data();
+  stepDrives(outData, inData);
+  // the modules echo their outputs
+  std::memcpy(inData + m_digitalInputs, outData + m_digitalOutputs, m_configuration.digitalModules*DIGITAL_BYTES);
+  std::memcpy(inData + m_analogInputs, outData + m_analogOutputs, m_configuration.analogModules*ANALOG_BYTES);
+}
+
+void PlantSimulator::stepDrives(const uint8_t* outData, uint8_t* inData){
+  const double response = 1.0/(1.0 + std::max(m_configuration.velocityTicks, 0.0));
+  for(uint32_t drive = 0; drive < m_configuration.drives; drive++){
+    uint16_t control = load<uint16_t>(outData, drive*DRIVE_OUTPUTS);
+    int32_t command = load<int32_t>(outData, drive*DRIVE_OUTPUTS + 2);
+    bool enable = (control & (CONTROL_ON | CONTROL_ENABLE)) == (CONTROL_ON | CONTROL_ENABLE);
+    DriveState& state = m_state[drive];
+    uint32_t& timer = m_timer[drive];
+    switch(state)
+    {
+      case PowerUp:
+        if(timer == 0 || --timer == 0)
+          state = Ready;
+        break;
+      case Ready:
+        if(enable){
+          state = Enabling;
+          timer = m_configuration.enableTicks;
+        }
+        break;
+      case Enabling:
+        if(!enable)
+          state = Ready;
+        else if(timer == 0 || --timer == 0){
+          state = Enabled;
+          m_toggle[drive] = control & CONTROL_TOGGLE;
+        }
+        break;
+      case Enabled:
+        if(!enable){
+          state = Ready;
+          break;
+        }
+        // the master toggles a bit of the control word every tick, a drive faults if it stops
+        if((control & CONTROL_TOGGLE) != m_toggle[drive]){
+          m_toggle[drive] = control & CONTROL_TOGGLE;
+          timer = 0;
+        }
+        else if(++timer >= m_configuration.watchdogTicks)
+          state = Fault;
+        break;
+      case Fault:
+        if(!(control & CONTROL_ON))
+          state = Ready;
+        break;
+    }
+
+    double target = state == Enabled && (control & CONTROL_HALT) ? command : 0.0;
+    m_velocity[drive] += (target - m_velocity[drive])*response;
+    m_position[drive] += m_velocity[drive]*m_configuration.positionScale;
+
+    uint16_t status = 0;
+    switch(state)
+    {
+      case PowerUp: status = 0; break;
+      case Ready: case Enabling: status = STATUS_READY; break;
+      case Enabled: status = STATUS_READY | STATUS_ENABLED; break;
+      case Fault: status = STATUS_READY | STATUS_ERROR; break;
+    }
+    store<uint16_t>(inData, drive*DRIVE_INPUTS, status);
+    // the feedback wraps like the 32 bit value of a real drive
+    store<int32_t>(inData, drive*DRIVE_INPUTS + 2, static_cast<int32_t>(static_cast<uint32_t>(static_cast<int64_t>(std::llround(m_position[drive])))));
+    store<int32_t>(inData, drive*DRIVE_INPUTS + 6, static_cast<int32_t>(std::lround(m_velocity[drive])));
+  }
+}
+
+void PlantSimulator::injectError(uint32_t drive){
+  if(drive < m_configuration.drives && m_state[drive] != PowerUp)
+    m_state[drive] = Fault;
+}
+
+uint32_t PlantSimulator::drivesInAF() const{
+  return static_cast<uint32_t>(std::count(m_state.begin(), m_state.end(), Enabled));
+}
+}
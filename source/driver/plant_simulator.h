@@ -0,0 +1,87 @@
+#pragma once
+#include "host_memory.h"
+#include "rt_process_image.h"
+#include <memory>
+#include <vector>
+
+namespace Example{
+  // Size and dynamics of the simulated plant
+  struct PlantConfiguration
+  {
+    uint32_t drives = 1;
+    uint32_t digitalModules = 1;  // DO_16_n echoed to DI_16_n, two 16 bit channels each
+    uint32_t analogModules = 0;   // AO_n echoed to AI_n, one 16 bit channel each
+    uint32_t powerUpTicks = 100;  // until the drives report ready (Ab)
+    uint32_t enableTicks = 5;     // from the enable to AF
+    uint32_t watchdogTicks = 3;   // ticks without comms toggle until a drive in AF faults
+    double velocityTicks = 10.0;  // time constant of the velocity response
+    double positionScale = 0.001; // position feedback per tick and velocity unit
+  };
+
+  // Stand-in for the realtime_data memories of an EtherCAT master with drives and I/O modules, e.g. to run
+  // user logic against a closed loop on the build host. Every step() computes the inputs from the outputs the tick wrote:
+  // each drive runs a status word state machine (power up, Ab, enabling, AF, error) on its control word,
+  // follows its velocity command with a first order lag while in AF and integrates the position; digital
+  // and analog outputs are echoed to the inputs of the paired module. The state is kept structure-of-arrays,
+  // a step costs about 10 ns per drive on a desktop CPU, so even thousands of drives run faster than real time.
+  class PlantSimulator
+  {
+    public:
+      explicit PlantSimulator(const PlantConfiguration& configuration);
+
+      // Binds like the memories of the master: bindMemory({plant.source()})
+      RealtimeSource source(const std::string& prefix = "") const;
+      // Once per tick before execute
+      void step();
+      // Drive error, cleared when the control word takes back the drive on bit
+      void injectError(uint32_t drive);
+      uint32_t drivesInAF() const;
+      HostMemory& inputs() { return *m_inputs; }
+      const ImageMap& inputMap() const { return m_inputMap; }
+      const PlantConfiguration& configuration() const { return m_configuration; }
+
+      // Drive profile of the simulated drives
+      static constexpr uint16_t CONTROL_ON = 0x8000;
+      static constexpr uint16_t CONTROL_ENABLE = 0x4000;
+      static constexpr uint16_t CONTROL_HALT = 0x2000; // active low: set while the drive may move
+      static constexpr uint16_t CONTROL_TOGGLE = 0x0400;
+      static constexpr uint16_t STATUS_READY = 0x8000; // Ab
+      static constexpr uint16_t STATUS_ENABLED = 0x4000; // with ready: AF
+      static constexpr uint16_t STATUS_ERROR = 0x2000;
+
+    private:
+      enum DriveState : uint8_t
+      {
+        PowerUp,
+        Ready,
+        Enabling,
+        Enabled,
+        Fault
+      };
+
+      // per drive: status word, position feedback, velocity feedback in; control word, velocity command out
+      static constexpr uint32_t DRIVE_INPUTS = 10;
+      static constexpr uint32_t DRIVE_OUTPUTS = 6;
+      static constexpr uint32_t DIGITAL_BYTES = 4;
+      static constexpr uint32_t ANALOG_BYTES = 2;
+
+      void layout();
+      void stepDrives(const uint8_t* outData, uint8_t* inData);
+
+      PlantConfiguration m_configuration;
+      std::shared_ptr<HostMemory> m_inputs;
+      std::shared_ptr<HostMemory> m_outputs;
+      ImageMap m_inputMap;
+      ImageMap m_outputMap;
+      uint32_t m_digitalInputs = 0; // byte offsets of the modules behind the drives
+      uint32_t m_digitalOutputs = 0;
+      uint32_t m_analogInputs = 0;
+      uint32_t m_analogOutputs = 0;
+
+      std::vector<DriveState> m_state;
+      std::vector<uint32_t> m_timer;
+      std::vector<uint16_t> m_toggle;
+      std::vector<double> m_velocity;
+      std::vector<double> m_position;
+  };
+}
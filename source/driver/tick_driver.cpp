@@ -0,0 +1,430 @@
+//
+// Host-side tick driver
+//
+// Runs RTApplication::execute against in-process images without scheduler and Data Layer.
+// The inputs follow a scripted machine cycle (power up, enable, motion, drive error, reset) that is
+// closed over the commanded velocity, so the same code paths are taken as on the controller.
+// Used to train the profile-guided build (build-pgo.sh), to measure the cost of a tick and, with --wcet, its worst case.
+// --counters adds the hardware counters of the tick phases, --timeline writes the execution timeline of all threads.
+// --plant N replaces the script by the plant simulator with N drives and their I/O modules, see plant_simulator.h.
+// The example logic only uses Axis1, so N changes the cost of the plant step rather than the cost of the tick.
+//
+#include "rt_application.h"
+#include "rt_control.h"
+#include "rt_publisher.h"
+#include "host_memory.h"
+#include "plant_simulator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  constexpr uint32_t INPUT_REVISION = 1;
+  constexpr uint32_t OUTPUT_REVISION = 1;
+  constexpr size_t IMAGE_SIZE = 256;
+
+  // offsets and sizes of the variables the user code binds to
+  const Example::ImageMap INPUT_MAP = {
+    {"Axis1/AT.Drive_status_word", {0*8, 16}},
+    {"Axis1/AT.Position_feedback_value_1", {2*8, 32}},
+  };
+  const Example::ImageMap OUTPUT_MAP = {
+    {"DO_16_1/Channel_1.Value", {0*8, 16}},
+    {"DO_16_1/Channel_2.Value", {8*8, 16}},
+    {"Axis1/MDT.Master_control_word", {2*8, 16}},
+    {"Axis1/MDT.VelocityCommand", {4*8, 32}},
+  };
+
+  // Scripted drive behaviour, one cycle every 5000 ticks
+  void replayInputs(uint64_t tick, Example::HostMemory& inputs, Example::HostMemory& outputs, int64_t& position){
+    uint64_t phase = tick % 5000;
+    uint16_t controlWord;
+    int32_t velocity;
+    std::memcpy(&controlWord, outputs.data() + OUTPUT_MAP.at("Axis1/MDT.Master_control_word").byteOffset(), sizeof(controlWord));
+    std::memcpy(&velocity, outputs.data() + OUTPUT_MAP.at("Axis1/MDT.VelocityCommand").byteOffset(), sizeof(velocity));
+
+    uint16_t statusWord = 0;
+    if(phase >= 100)
+      statusWord = ST_DriveInAb;
+    if(phase >= 100 && (controlWord & CMD_DriveON) != 0)
+      statusWord = ST_DriveInAF;
+    if(phase >= 4000 && phase < 4100)
+      statusWord |= ST_DriveError;
+    if((statusWord & ST_DriveInAF) == ST_DriveInAF)
+      position += velocity/1000;
+
+    int32_t feedback = static_cast<int32_t>(position);
+    std::memcpy(inputs.data() + INPUT_MAP.at("Axis1/AT.Drive_status_word").byteOffset(), &statusWord, sizeof(statusWord));
+    std::memcpy(inputs.data() + INPUT_MAP.at("Axis1/AT.Position_feedback_value_1").byteOffset(), &feedback, sizeof(feedback));
+  }
+
+  // Input patterns of the WCET sweep, each applied for SWEEP_TICKS ticks on top of the scripted cycle
+  enum SweepPattern : uint32_t
+  {
+    Scripted,
+    AllDrivesFaulted, // every drive reports an error at once
+    AllBitsSet,
+    AllBitsCleared,
+    Noise,
+    SWEEP_PATTERNS
+  };
+  constexpr uint64_t SWEEP_TICKS = 1000;
+
+  void sweepInputs(uint64_t tick, Example::HostMemory& inputs, const Example::ImageMap& inputMap, uint64_t& noise){
+    switch(static_cast<SweepPattern>(tick/SWEEP_TICKS % SWEEP_PATTERNS))
+    {
+      case AllDrivesFaulted:
+        for(auto& variable : inputMap){
+          if(variable.first.find("Drive_status_word") != std::string_view::npos){
+            uint16_t statusWord = ST_DriveInAF | ST_DriveError | ST_DriveWarning;
+            std::memcpy(inputs.data() + variable.second.byteOffset(), &statusWord, sizeof(statusWord));
+          }
+        }
+        break;
+      case AllBitsSet:
+        std::memset(inputs.data(), 0xFF, inputs.size());
+        break;
+      case AllBitsCleared:
+        std::memset(inputs.data(), 0, inputs.size());
+        break;
+      case Noise:
+        for(size_t offset = 0; offset < inputs.size(); offset++){
+          noise = noise*6364136223846793005ull + 1442695040888963407ull;
+          inputs.data()[offset] = static_cast<uint8_t>(noise >> 56);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  void printWcet(Example::WcetProbe& wcet){
+    for(bool cold : {true, false}){
+      for(auto& phase : wcet.statistics(cold))
+        std::printf("wcet %s %-9s samples=%zu p50_ns=%u p99_ns=%u p999_ns=%u max_ns=%u\n", cold ? "cold" : "warm", phase.phase,
+                    phase.samples, phase.p50, phase.p99, phase.p999, phase.max);
+    }
+  }
+
+  // Windows are summed as they complete, the queue of the probe only holds a few
+  void collectCounters(Example::WcetProbe& wcet, Example::CounterWindow& total){
+    Example::CounterWindow window;
+    while(wcet.poll(window)){
+      total.counters = total.ticks ? total.counters && window.counters : window.counters;
+      total.ticks += window.ticks;
+      for(size_t phase = 0; phase < Example::WCET_PHASES; phase++){
+        total.phases[phase].nanoseconds += window.phases[phase].nanoseconds;
+        for(size_t counter = 0; counter < Example::PERF_COUNTERS; counter++)
+          total.phases[phase].counts[counter] += window.phases[phase].counts[counter];
+      }
+    }
+  }
+
+  // Per tick over all windows
+  void printCounters(const Example::CounterWindow& total){
+    if(!total.ticks)
+      return;
+    double ticks = total.ticks;
+    for(size_t phase = 0; phase < Example::WCET_PHASES; phase++){
+      auto& counts = total.phases[phase];
+      const char* name = Example::wcetPhaseName(Example::WcetPhase(phase));
+      if(!total.counters){
+        std::printf("counters %-9s ticks=%u ns=%.1f (timing only)\n", name, total.ticks, counts.nanoseconds/ticks);
+        continue;
+      }
+      double cycles = counts.counts[size_t(Example::PerfCounter::Cycles)];
+      double instructions = counts.counts[size_t(Example::PerfCounter::Instructions)];
+      std::printf("counters %-9s ticks=%u ns=%.1f cycles=%.1f instructions=%.1f ipc=%.2f cache_misses=%.2f branch_misses=%.2f\n", name,
+                  total.ticks, counts.nanoseconds/ticks, cycles/ticks, instructions/ticks, cycles ? instructions/cycles : 0.0,
+                  counts.counts[size_t(Example::PerfCounter::CacheMisses)]/ticks, counts.counts[size_t(Example::PerfCounter::BranchMisses)]/ticks);
+    }
+  }
+
+  // Bitwise comparison of all analog kernels the CPU supports against the scalar reference
+  int verifyAnalog(){
+    int result = 0;
+    for(auto kernels : Example::supportedAnalogKernels()){
+      bool equal = Example::verifyAnalogKernels(*kernels, 1u << 24);
+      std::printf("analog kernels %-8s %s\n", kernels->name, equal ? "bitwise equal" : "DIFFERENT");
+      if(!equal)
+        result = 1;
+    }
+    return result;
+  }
+
+  // Maps that were moved from are reused, e.g. when the process image is bound again
+  int verifyContainers(){
+    int result = 0;
+    auto check = [&](const char* name, bool passed){
+      std::printf("containers %-28s %s\n", name, passed ? "ok" : "FAILED");
+      if(!passed)
+        result = 1;
+    };
+    Example::ImageMap source = {{"Axis1/AT.Drive_status_word", {0, 16}}, {"Axis1/AT.Position_feedback_value_1", {16, 32}}};
+    Example::ImageMap moved(std::move(source));
+    check("move construct", moved.size() == 2 && moved.at("Axis1/AT.Position_feedback_value_1").bitOffset == 16);
+    check("moved-from is empty", source.empty() && !source.contains("Axis1/AT.Drive_status_word"));
+    source.insert("DI_16_1/Channel_1.Value", {64, 16});
+    source.insert("AI_1/Channel_1.Value", {96, 16});
+    source.sort();
+    check("insert after move construct", source.size() == 2 && source.at("DI_16_1/Channel_1.Value").bitOffset == 64);
+    Example::ImageMap assigned;
+    assigned.insert("DO_16_1/Channel_1.Value", {0, 16});
+    assigned = std::move(moved);
+    check("move assign", assigned.size() == 2 && assigned.at("Axis1/AT.Drive_status_word").bitSize == 16 && !assigned.contains("DO_16_1/Channel_1.Value"));
+    moved.insert("Axis2/AT.Drive_status_word", {0, 16});
+    assigned.insert("Axis3/AT.Drive_status_word", {128, 16});
+    assigned.sort();
+    check("insert after move assign", moved.size() == 1 && moved.contains("Axis2/AT.Drive_status_word") && assigned.size() == 3 &&
+          assigned.at("Axis3/AT.Drive_status_word").bitOffset == 128);
+    return result;
+  }
+
+  // Published values read back from an in-process memory, as another RT app would see them
+  int verifyPublisher(){
+    int result = 0;
+    auto check = [&](const char* name, bool passed){
+      std::printf("publisher %-28s %s\n", name, passed ? "ok" : "FAILED");
+      if(!passed)
+        result = 1;
+    };
+    int32_t velocity = -123456;
+    uint16_t statusWord = ST_DriveInAF;
+    double position = 12.5;
+    uint8_t image[8] = {0, 0, 0x34, 0x12};
+    Example::RealtimePublisher publisher;
+    publisher.addValue("Axis1/ActVelocity", Example::SignalRef::variable(&velocity, Example::SignalType::Int32));
+    publisher.addValue("Axis1/StatusWord", Example::SignalRef::variable(&statusWord, Example::SignalType::UInt16));
+    publisher.addValue("Axis1/Position", Example::SignalRef::variable(&position, Example::SignalType::Float64));
+    publisher.addValue("DI_16_1/Channel_1.Value", Example::SignalRef::image(2*8, Example::SignalType::UInt16));
+    check("create without factory", !publisher.create(nullptr, nullptr, Example::PUBLISH_DEFAULT_ADDRESS) && !publisher.empty());
+    auto memory = std::make_shared<Example::HostOwnedMemory>(64, comm::datalayer::MemoryType_Input);
+    check("attach", publisher.attach(memory) && publisher.isCreated() && memory->maps() == 1 && publisher.size() <= 64);
+    auto readBack = [&](const char* name, void* value, size_t size){
+      int64_t offset = publisher.offsetOf(name);
+      if(offset < 0)
+        return false;
+      std::memcpy(value, memory->data() + offset, size);
+      return true;
+    };
+    int32_t publishedVelocity = 0;
+    uint16_t publishedStatus = 0;
+    uint16_t publishedInput = 0;
+    double publishedPosition = 0;
+    check("publish", publisher.publish(image));
+    check("values read back", readBack("Axis1/ActVelocity", &publishedVelocity, 4) && readBack("Axis1/StatusWord", &publishedStatus, 2) &&
+          readBack("Axis1/Position", &publishedPosition, 8) && readBack("DI_16_1/Channel_1.Value", &publishedInput, 2) &&
+          publishedVelocity == velocity && publishedStatus == statusWord && publishedPosition == position && publishedInput == 0x1234);
+    velocity = 42;
+    check("attach again keeps values", publisher.attach(memory) && memory->maps() == 2 && publisher.publish(image) &&
+          readBack("Axis1/ActVelocity", &publishedVelocity, 4) && publishedVelocity == 42);
+    publisher.destroy();
+    check("destroy", !publisher.isCreated() && publisher.empty() && !publisher.publish(image));
+    return result;
+  }
+
+  // Cost of one update of a bank of control loops, e.g. 200 loops of PID and notch filter per tick
+  int benchControl(uint32_t loops, uint64_t ticks){
+    Example::PidParameters parameters;
+    parameters.kp = 1.0f;
+    parameters.ki = 10.0f;
+    parameters.kd = 0.01f;
+    parameters.derivativeFilter = 0.002f;
+    Example::PidBank pids;
+    Example::BiquadBank filters;
+    for(uint32_t loop = 0; loop < loops; loop++){
+      pids.add(parameters, 0.001f);
+      filters.add(Example::BiquadCoefficients::notch(120.0, 2.0, 0.001));
+    }
+    float measurement = 0.0f;
+    auto begin = std::chrono::steady_clock::now();
+    for(uint64_t tick = 0; tick < ticks; tick++){
+      for(uint32_t loop = 0; loop < loops; loop++)
+        pids.setInput(loop, 1.0f, filters.output(loop));
+      pids.update();
+      measurement = pids.output(0);
+      for(uint32_t loop = 0; loop < loops; loop++)
+        filters.setInput(loop, measurement);
+      filters.update();
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::printf("control loops=%u ticks=%zu mean_ns=%.1f\n", loops, static_cast<size_t>(ticks),
+                std::chrono::duration<double, std::nano>(end - begin).count()/ticks);
+    return 0;
+  }
+
+  void usage(){
+    std::printf("usage: tick_driver [--ticks N] [--warmup N] [--command-threads N] [--wcet N [--sweep]] [--counters WINDOW] [--timeline FILE] [--plant DRIVES] [--verify-analog] [--verify-containers] [--verify-publisher] [--bench-control LOOPS]\n");
+  }
+}
+
+int main(int argc, char** argv){
+  uint64_t ticks = 100000;
+  uint64_t warmup = 1000;
+  uint32_t commandThreads = 0;
+  uint32_t wcetEvery = 0;
+  uint32_t counterWindow = 0;
+  std::string timeline;
+  uint32_t plantDrives = 0;
+  bool sweep = false;
+  for(int arg = 1; arg < argc; arg++){
+    std::string option = argv[arg];
+    if(option == "--ticks" && arg + 1 < argc)
+      ticks = std::stoull(argv[++arg]);
+    else if(option == "--warmup" && arg + 1 < argc)
+      warmup = std::stoull(argv[++arg]);
+    else if(option == "--command-threads" && arg + 1 < argc)
+      commandThreads = std::stoul(argv[++arg]);
+    else if(option == "--wcet" && arg + 1 < argc)
+      wcetEvery = std::stoul(argv[++arg]);
+    else if(option == "--counters" && arg + 1 < argc)
+      counterWindow = std::stoul(argv[++arg]);
+    else if(option == "--timeline" && arg + 1 < argc)
+      timeline = argv[++arg];
+    else if(option == "--plant" && arg + 1 < argc)
+      plantDrives = std::stoul(argv[++arg]);
+    else if(option == "--sweep")
+      sweep = true;
+    else if(option == "--verify-analog")
+      return verifyAnalog();
+    else if(option == "--verify-containers")
+      return verifyContainers();
+    else if(option == "--verify-publisher")
+      return verifyPublisher();
+    else if(option == "--bench-control" && arg + 1 < argc)
+      return benchControl(std::stoul(argv[++arg]), ticks);
+    else{
+      usage();
+      return 1;
+    }
+  }
+
+  auto inputs = std::make_shared<Example::HostMemory>(IMAGE_SIZE, INPUT_REVISION, comm::datalayer::MemoryType_Input);
+  auto outputs = std::make_shared<Example::HostMemory>(IMAGE_SIZE, OUTPUT_REVISION, comm::datalayer::MemoryType_Output);
+  // a module pair per four drives, the user code binds the first of each
+  Example::PlantConfiguration configuration;
+  configuration.drives = plantDrives;
+  configuration.digitalModules = std::max(1u, plantDrives/4);
+  configuration.analogModules = std::max(1u, plantDrives/4);
+  Example::PlantSimulator plant(configuration);
+  auto application = std::make_shared<Example::RTApplication>();
+  if(plantDrives)
+    application->bindMemory({plant.source()});
+  else
+    application->bindMemory({{"", inputs, INPUT_MAP, INPUT_REVISION, outputs, OUTPUT_MAP, OUTPUT_REVISION}});
+  // every N-th tick cold, e.g. --wcet 10 --sweep
+  if(wcetEvery)
+    application->wcet().enable(wcetEvery);
+  if(counterWindow)
+    application->wcet().enableCounters(counterWindow);
+  // the ticks follow each other without pause here, sections beyond the rings are dropped and counted
+  if(!timeline.empty() && !Example::Timeline::start(timeline))
+    std::printf("timeline %s not created\n", timeline.c_str());
+  uint64_t noise = 1;
+  Example::CounterWindow counters{};
+  // there is no worker pool here, the windows are taken like reportTelemetry does
+  Example::TelemetryWindow telemetryWindow;
+  uint64_t telemetryWindows = 0;
+
+  comm::datalayer::Variant param;
+  auto tickEvent = common::scheduler::SchedEventType::SCHED_EVENT_TICK;
+  auto tickPhase = common::scheduler::SchedEventPhase();
+  int64_t position = 0;
+  std::vector<uint32_t> durations;
+  durations.reserve(ticks);
+  double plantSumNs = 0;
+
+  // operator commands from concurrent threads, they keep the secondary operation mode so the cycle is unchanged
+  std::atomic<bool> ticking{true};
+  std::atomic<uint64_t> completed{0};
+  std::atomic<uint64_t> failed{0};
+  std::vector<std::thread> issuers;
+  for(uint32_t thread = 0; thread < commandThreads; thread++)
+    issuers.emplace_back([&]{
+      while(ticking.load(std::memory_order_relaxed)){
+        Example::CommandResult result;
+        bool done = application->commands().execute({COMMAND_OPERATION_MODE, 1, 1}, result, std::chrono::milliseconds(100));
+        (done && result.status == COMMAND_DONE ? completed : failed).fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+
+  for(uint64_t tick = 0; tick < warmup + ticks; tick++){
+    if(plantDrives){
+      // same cycle as the script: a drive error on the first drive every 5000 ticks
+      if(tick % 5000 == 4000)
+        plant.injectError(0);
+      auto begin = std::chrono::steady_clock::now();
+      plant.step();
+      auto end = std::chrono::steady_clock::now();
+      if(tick >= warmup)
+        plantSumNs += std::chrono::duration<double, std::nano>(end - begin).count();
+    }
+    else
+      replayInputs(tick, *inputs, *outputs, position);
+    if(sweep)
+      sweepInputs(tick, plantDrives ? plant.inputs() : *inputs, plantDrives ? plant.inputMap() : INPUT_MAP, noise);
+    if(tick == warmup){
+      application->wcet().reset();
+      // windows of the warmup are dropped
+      counters = Example::CounterWindow{};
+    }
+    auto begin = std::chrono::steady_clock::now();
+    application->execute(tickEvent, tickPhase, param);
+    auto end = std::chrono::steady_clock::now();
+    collectCounters(application->wcet(), counters);
+    while(application->telemetry().poll(telemetryWindow))
+      telemetryWindows++;
+    if(tick >= warmup)
+      durations.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+  }
+  ticking = false;
+  for(auto& issuer : issuers)
+    issuer.join();
+  // SDK_EXAMPLE_SHADOW=logic.so compares a candidate module with the compiled-in logic
+  Example::ShadowReport report;
+  Example::ShadowReport shadow{};
+  while(application->shadow().poll(report)){
+    shadow.ticks += report.ticks;
+    shadow.divergentTicks += report.divergentTicks;
+    shadow.activeSumNs += report.activeSumNs;
+    shadow.candidateSumNs += report.candidateSumNs;
+  }
+  if(shadow.ticks)
+    std::printf("shadow ticks=%u divergent=%u active_mean_ns=%.1f candidate_mean_ns=%.1f\n", shadow.ticks, shadow.divergentTicks,
+                double(shadow.activeSumNs)/shadow.ticks, double(shadow.candidateSumNs)/shadow.ticks);
+  if(application->wcet().enabled()){
+    printWcet(application->wcet());
+    application->wcet().disable();
+  }
+  if(application->wcet().countersEnabled()){
+    printCounters(counters);
+    application->wcet().disableCounters();
+  }
+  if(Example::Timeline::enabled()){
+    Example::Timeline::stop();
+    std::printf("timeline %s dropped=%lu\n", timeline.c_str(), static_cast<unsigned long>(Example::Timeline::dropped()));
+  }
+  if(telemetryWindows)
+    std::printf("telemetry windows=%lu dropped=%lu\n", static_cast<unsigned long>(telemetryWindows),
+                static_cast<unsigned long>(application->telemetry().droppedWindows()));
+  application->unbindMemory();
+  if(plantDrives && ticks)
+    std::printf("plant drives=%u step_mean_ns=%.1f in_af=%u\n", plantDrives, plantSumNs/ticks, plant.drivesInAF());
+  if(commandThreads)
+    std::printf("commands completed=%lu failed=%lu\n", static_cast<unsigned long>(completed.load()), static_cast<unsigned long>(failed.load()));
+
+  if(durations.empty())
+    return 0;
+  double sum = 0;
+  for(auto duration : durations)
+    sum += duration;
+  std::sort(durations.begin(), durations.end());
+  auto percentile = [&](double p){ return durations[std::min(durations.size() - 1, static_cast<size_t>(p*durations.size()))]; };
+  std::printf("ticks=%zu mean_ns=%.1f p50_ns=%u p99_ns=%u max_ns=%u\n", durations.size(), sum/durations.size(),
+              percentile(0.5), percentile(0.99), durations.back());
+  return 0;
+}
@@ -57,8 +57,9 @@ class ConsoleLogger
     static constexpr const char *red = "\033[31m";
 
     inline static const bool isDebugEnvironment = [] {
-        const std::string snapEnv = std::getenv("SNAP_ENV"); // NOLINT(concurrency-mt-unsafe)
-        return snapEnv == "DEBUG";
+        // not set outside of a snap, e.g. in the host-side tick driver
+        const char *snapEnv = std::getenv("SNAP_ENV"); // NOLINT(concurrency-mt-unsafe)
+        return snapEnv != nullptr && std::string(snapEnv) == "DEBUG";
     }();
 
   public:
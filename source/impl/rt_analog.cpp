@@ -0,0 +1,344 @@
+#include "rt_analog.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+// Note: this file is compiled with -ffp-contract=off, a fused multiply-add would change the rounding
+// of the scalar reference compared to the vector kernels.
+
+namespace Example{
+namespace {
+  inline float clampScalar(float value, float min, float max){
+    value = value < max ? value : max;
+    return value > min ? value : min;
+  }
+
+  void toEngineeringScalar(const int16_t* raw, float* value, const float* scale, const float* offset,
+                           const float* min, const float* max, size_t count){
+    for(size_t i = 0; i < count; i++){
+      float v = static_cast<float>(raw[i])*scale[i];
+      v = v + offset[i];
+      value[i] = clampScalar(v, min[i], max[i]);
+    }
+  }
+
+  void toRawScalar(const float* value, int16_t* raw, const float* invScale, const float* offset,
+                   const float* min, const float* max, size_t count){
+    for(size_t i = 0; i < count; i++){
+      float v = clampScalar(value[i], min[i], max[i]);
+      v = (v - offset[i])*invScale[i];
+      v = clampScalar(v, -32768.0f, 32767.0f);
+      raw[i] = static_cast<int16_t>(std::nearbyint(v));
+    }
+  }
+
+  const AnalogKernels SCALAR_KERNELS = {"scalar", toEngineeringScalar, toRawScalar};
+
+#if defined(__x86_64__)
+  __attribute__((target("sse4.1")))
+  void toEngineeringSse4(const int16_t* raw, float* value, const float* scale, const float* offset,
+                         const float* min, const float* max, size_t count){
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+      __m128i r = _mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(raw + i)));
+      __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(r), _mm_loadu_ps(scale + i));
+      v = _mm_add_ps(v, _mm_loadu_ps(offset + i));
+      v = _mm_max_ps(_mm_min_ps(v, _mm_loadu_ps(max + i)), _mm_loadu_ps(min + i));
+      _mm_storeu_ps(value + i, v);
+    }
+    toEngineeringScalar(raw + i, value + i, scale + i, offset + i, min + i, max + i, count - i);
+  }
+
+  __attribute__((target("sse4.1")))
+  void toRawSse4(const float* value, int16_t* raw, const float* invScale, const float* offset,
+                 const float* min, const float* max, size_t count){
+    const __m128 lowest = _mm_set1_ps(-32768.0f);
+    const __m128 highest = _mm_set1_ps(32767.0f);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+      __m128i half[2];
+      for(size_t h = 0; h < 2; h++){
+        size_t j = i + 4*h;
+        __m128 v = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(value + j), _mm_loadu_ps(max + j)), _mm_loadu_ps(min + j));
+        v = _mm_mul_ps(_mm_sub_ps(v, _mm_loadu_ps(offset + j)), _mm_loadu_ps(invScale + j));
+        v = _mm_max_ps(_mm_min_ps(v, highest), lowest);
+        half[h] = _mm_cvtps_epi32(v);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(raw + i), _mm_packs_epi32(half[0], half[1]));
+    }
+    toRawScalar(value + i, raw + i, invScale + i, offset + i, min + i, max + i, count - i);
+  }
+
+  __attribute__((target("avx2")))
+  void toEngineeringAvx2(const int16_t* raw, float* value, const float* scale, const float* offset,
+                         const float* min, const float* max, size_t count){
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+      __m256i r = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(raw + i)));
+      __m256 v = _mm256_mul_ps(_mm256_cvtepi32_ps(r), _mm256_loadu_ps(scale + i));
+      v = _mm256_add_ps(v, _mm256_loadu_ps(offset + i));
+      v = _mm256_max_ps(_mm256_min_ps(v, _mm256_loadu_ps(max + i)), _mm256_loadu_ps(min + i));
+      _mm256_storeu_ps(value + i, v);
+    }
+    toEngineeringScalar(raw + i, value + i, scale + i, offset + i, min + i, max + i, count - i);
+  }
+
+  __attribute__((target("avx2")))
+  void toRawAvx2(const float* value, int16_t* raw, const float* invScale, const float* offset,
+                 const float* min, const float* max, size_t count){
+    const __m256 lowest = _mm256_set1_ps(-32768.0f);
+    const __m256 highest = _mm256_set1_ps(32767.0f);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8){
+      __m256 v = _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(value + i), _mm256_loadu_ps(max + i)), _mm256_loadu_ps(min + i));
+      v = _mm256_mul_ps(_mm256_sub_ps(v, _mm256_loadu_ps(offset + i)), _mm256_loadu_ps(invScale + i));
+      v = _mm256_max_ps(_mm256_min_ps(v, highest), lowest);
+      __m256i r = _mm256_cvtps_epi32(v);
+      __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(raw + i), packed);
+    }
+    toRawScalar(value + i, raw + i, invScale + i, offset + i, min + i, max + i, count - i);
+  }
+
+  const AnalogKernels SSE4_KERNELS = {"sse4.1", toEngineeringSse4, toRawSse4};
+  const AnalogKernels AVX2_KERNELS = {"avx2", toEngineeringAvx2, toRawAvx2};
+
+#elif defined(__aarch64__)
+  inline float32x4_t clampNeon(float32x4_t value, float32x4_t min, float32x4_t max){
+    // compare and select instead of vminq/vmaxq, which propagate NaN differently
+    value = vbslq_f32(vcltq_f32(value, max), value, max);
+    return vbslq_f32(vcgtq_f32(value, min), value, min);
+  }
+
+  void toEngineeringNeon(const int16_t* raw, float* value, const float* scale, const float* offset,
+                         const float* min, const float* max, size_t count){
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+      float32x4_t v = vcvtq_f32_s32(vmovl_s16(vld1_s16(raw + i)));
+      v = vmulq_f32(v, vld1q_f32(scale + i));
+      v = vaddq_f32(v, vld1q_f32(offset + i));
+      vst1q_f32(value + i, clampNeon(v, vld1q_f32(min + i), vld1q_f32(max + i)));
+    }
+    toEngineeringScalar(raw + i, value + i, scale + i, offset + i, min + i, max + i, count - i);
+  }
+
+  void toRawNeon(const float* value, int16_t* raw, const float* invScale, const float* offset,
+                 const float* min, const float* max, size_t count){
+    const float32x4_t lowest = vdupq_n_f32(-32768.0f);
+    const float32x4_t highest = vdupq_n_f32(32767.0f);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4){
+      float32x4_t v = clampNeon(vld1q_f32(value + i), vld1q_f32(min + i), vld1q_f32(max + i));
+      v = vmulq_f32(vsubq_f32(v, vld1q_f32(offset + i)), vld1q_f32(invScale + i));
+      v = clampNeon(v, lowest, highest);
+      vst1_s16(raw + i, vqmovn_s32(vcvtnq_s32_f32(v)));
+    }
+    toRawScalar(value + i, raw + i, invScale + i, offset + i, min + i, max + i, count - i);
+  }
+
+  const AnalogKernels NEON_KERNELS = {"neon", toEngineeringNeon, toRawNeon};
+#endif
+}
+
+const AnalogKernels& scalarAnalogKernels(){
+  return SCALAR_KERNELS;
+}
+
+std::vector<const AnalogKernels*> supportedAnalogKernels(){
+  std::vector<const AnalogKernels*> kernels;
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2"))
+    kernels.push_back(&AVX2_KERNELS);
+  if(__builtin_cpu_supports("sse4.1"))
+    kernels.push_back(&SSE4_KERNELS);
+#elif defined(__aarch64__)
+  if(getauxval(AT_HWCAP) & HWCAP_ASIMD)
+    kernels.push_back(&NEON_KERNELS);
+#endif
+  kernels.push_back(&SCALAR_KERNELS);
+  return kernels;
+}
+
+bool verifyAnalogKernels(const AnalogKernels& kernels, size_t outputSamples){
+  // parameter sets covering unit scaling, offsets, tight and open clamps
+  const float scales[] = {1.0f, 10.0f/32767.0f, -0.0125f, 3.5f};
+  const float offsets[] = {0.0f, -1.25f, 0.1f, 4000.0f};
+  const float mins[] = {-1e9f, -10.0f, -5.0f, 0.0f};
+  const float maxs[] = {1e9f, 10.0f, 5.0f, 20000.0f};
+  constexpr size_t SETS = 4;
+  constexpr size_t CHUNK = 1000; // not a multiple of the vector width, the tails are checked as well
+
+  std::vector<float> scale(CHUNK), invScale(CHUNK), offset(CHUNK), min(CHUNK), max(CHUNK);
+  for(size_t i = 0; i < CHUNK; i++){
+    scale[i] = scales[i % SETS];
+    invScale[i] = 1.0f/scales[i % SETS];
+    offset[i] = offsets[(i/SETS) % SETS];
+    min[i] = mins[(i/(SETS*SETS)) % SETS];
+    max[i] = maxs[(i/(SETS*SETS)) % SETS];
+  }
+
+  std::vector<int16_t> raw(CHUNK), rawReference(CHUNK);
+  std::vector<float> value(CHUNK), valueReference(CHUNK);
+  for(int32_t first = -32768; first <= 32767; first += CHUNK){
+    for(size_t i = 0; i < CHUNK; i++)
+      raw[i] = static_cast<int16_t>(std::clamp<int32_t>(first + static_cast<int32_t>(i), -32768, 32767));
+    SCALAR_KERNELS.toEngineering(raw.data(), valueReference.data(), scale.data(), offset.data(), min.data(), max.data(), CHUNK);
+    kernels.toEngineering(raw.data(), value.data(), scale.data(), offset.data(), min.data(), max.data(), CHUNK);
+    if(std::memcmp(value.data(), valueReference.data(), CHUNK*sizeof(float)) != 0)
+      return false;
+  }
+
+  // engineering values from well inside to far outside the raw range, including halfway cases
+  uint32_t seed = 12345;
+  for(size_t done = 0; done < outputSamples; done += CHUNK){
+    for(size_t i = 0; i < CHUNK; i++){
+      seed = seed*1664525u + 1013904223u;
+      float unit = static_cast<float>(seed >> 8)/static_cast<float>(1u << 24)*2.0f - 1.0f;
+      value[i] = (i % 7 == 0) ? std::round(unit*70000.0f) + 0.5f : unit*70000.0f;
+    }
+    SCALAR_KERNELS.toRaw(value.data(), rawReference.data(), invScale.data(), offset.data(), min.data(), max.data(), CHUNK);
+    kernels.toRaw(value.data(), raw.data(), invScale.data(), offset.data(), min.data(), max.data(), CHUNK);
+    if(std::memcmp(raw.data(), rawReference.data(), CHUNK*sizeof(int16_t)) != 0)
+      return false;
+  }
+  return true;
+}
+
+int AnalogConverter::Channels::add(uint32_t bitOffset, float scale, float offset, float min, float max){
+  byteOffset.push_back(bitOffset/8);
+  this->scale.push_back(scale);
+  this->offset.push_back(offset);
+  this->min.push_back(min);
+  this->max.push_back(max);
+  return static_cast<int>(byteOffset.size()) - 1;
+}
+
+void AnalogConverter::Channels::group(){
+  // sort the parameters by image offset so that a group is one contiguous run for the kernels
+  std::vector<uint32_t> order(byteOffset.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return byteOffset[a] < byteOffset[b]; });
+  auto permute = [&](auto& values){
+    auto copy = values;
+    for(size_t i = 0; i < order.size(); i++)
+      values[i] = copy[order[i]];
+  };
+  slot.assign(order.size(), 0);
+  for(size_t i = 0; i < order.size(); i++)
+    slot[order[i]] = static_cast<uint32_t>(i);
+  std::vector<uint32_t> sortedOffset = byteOffset;
+  permute(sortedOffset);
+  permute(scale);
+  permute(offset);
+  permute(min);
+  permute(max);
+  value.assign(order.size(), 0.0f);
+
+  groups.clear();
+  for(uint32_t i = 0; i < sortedOffset.size(); i++){
+    if(!groups.empty() && sortedOffset[i] == groups.back().byteOffset + 2*groups.back().count)
+      groups.back().count++;
+    else
+      groups.push_back(Group{sortedOffset[i], i, 1});
+  }
+}
+
+void AnalogConverter::Channels::clear(){
+  byteOffset.clear();
+  scale.clear();
+  offset.clear();
+  min.clear();
+  max.clear();
+  slot.clear();
+  value.clear();
+  groups.clear();
+}
+
+int AnalogConverter::addInput(std::string_view name, uint32_t bitOffset, float scale, float offset, float min, float max){
+  if(bitOffset % 8 != 0){
+    LOG_WARNING("Analog input %.*s is not byte aligned", static_cast<int>(name.size()), name.data());
+    return -1;
+  }
+  return m_inputs.add(bitOffset, scale, offset, min, max);
+}
+
+int AnalogConverter::addOutput(std::string_view name, uint32_t bitOffset, float scale, float offset, float min, float max){
+  if(bitOffset % 8 != 0 || scale == 0.0f){
+    LOG_WARNING("Analog output %.*s is not byte aligned or has no scale", static_cast<int>(name.size()), name.data());
+    return -1;
+  }
+  return m_outputs.add(bitOffset, 1.0f/scale, offset, min, max);
+}
+
+void AnalogConverter::bind(const std::string& kernel){
+  m_inputs.group();
+  m_outputs.group();
+  size_t largest = 0;
+  for(auto& group : m_inputs.groups)
+    largest = std::max<size_t>(largest, group.count);
+  for(auto& group : m_outputs.groups)
+    largest = std::max<size_t>(largest, group.count);
+  m_raw.assign(largest, 0);
+
+  // the first supported implementation that matches the reference is used for all ticks
+  m_kernels = &scalarAnalogKernels();
+  for(auto candidate : supportedAnalogKernels()){
+    if(!kernel.empty() && kernel != candidate->name)
+      continue;
+    if(candidate != &scalarAnalogKernels() && !verifyAnalogKernels(*candidate, 4096)){
+      LOG_WARNING("Analog kernels %s differ from the reference and are not used", candidate->name);
+      continue;
+    }
+    m_kernels = candidate;
+    break;
+  }
+  LOG_INFO("Analog conversion: %zu inputs in %zu groups, %zu outputs in %zu groups, kernels %s",
+           m_inputs.value.size(), m_inputs.groups.size(), m_outputs.value.size(), m_outputs.groups.size(), m_kernels->name);
+}
+
+void AnalogConverter::clear(){
+  m_inputs.clear();
+  m_outputs.clear();
+  m_raw.clear();
+  m_kernels = nullptr;
+}
+
+void AnalogConverter::readInputs(const uint8_t* inData){
+  if(!m_kernels)
+    return;
+  for(auto& group : m_inputs.groups){
+    const uint8_t* source = inData + group.byteOffset;
+    const int16_t* raw = reinterpret_cast<const int16_t*>(source);
+    if(reinterpret_cast<uintptr_t>(source) % alignof(int16_t) != 0){
+      std::memcpy(m_raw.data(), source, group.count*sizeof(int16_t));
+      raw = m_raw.data();
+    }
+    m_kernels->toEngineering(raw, &m_inputs.value[group.first], &m_inputs.scale[group.first], &m_inputs.offset[group.first],
+                             &m_inputs.min[group.first], &m_inputs.max[group.first], group.count);
+  }
+}
+
+void AnalogConverter::writeOutputs(uint8_t* outData){
+  if(!m_kernels)
+    return;
+  for(auto& group : m_outputs.groups){
+    uint8_t* target = outData + group.byteOffset;
+    bool aligned = reinterpret_cast<uintptr_t>(target) % alignof(int16_t) == 0;
+    int16_t* raw = aligned ? reinterpret_cast<int16_t*>(target) : m_raw.data();
+    m_kernels->toRaw(&m_outputs.value[group.first], raw, &m_outputs.scale[group.first], &m_outputs.offset[group.first],
+                     &m_outputs.min[group.first], &m_outputs.max[group.first], group.count);
+    if(!aligned)
+      std::memcpy(target, m_raw.data(), group.count*sizeof(int16_t));
+  }
+}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Example{
+  // Batched conversion between raw int16 channels and engineering units.
+  //   input:  value = clamp(raw*scale + offset, min, max)
+  //   output: raw = round_even(clamp((clamp(value, min, max) - offset)*invScale, -32768, 32767))
+  // clamp(v, lo, hi) is defined as (v < hi ? v : hi) followed by (v > lo ? v : lo), which is what the
+  // SSE/AVX min/max instructions do, so every implementation gives bitwise identical results.
+  struct AnalogKernels
+  {
+    const char* name;
+    void (*toEngineering)(const int16_t* raw, float* value, const float* scale, const float* offset,
+                          const float* min, const float* max, size_t count);
+    void (*toRaw)(const float* value, int16_t* raw, const float* invScale, const float* offset,
+                  const float* min, const float* max, size_t count);
+  };
+
+  // Scalar reference implementation
+  const AnalogKernels& scalarAnalogKernels();
+  // All implementations the CPU supports, best first; the scalar reference is always the last entry
+  std::vector<const AnalogKernels*> supportedAnalogKernels();
+  // Compares an implementation bitwise against the scalar reference, over the whole int16 range
+  // for inputs and a sweep of engineering values for outputs
+  bool verifyAnalogKernels(const AnalogKernels& kernels, size_t outputSamples = 1u << 16);
+
+  // Analog channels of the process image, grouped into runs of adjacent int16 channels
+  class AnalogConverter
+  {
+    public:
+      // Configuration, non-RT. Returns the channel index or -1.
+      int addInput(std::string_view name, uint32_t bitOffset, float scale, float offset, float min, float max);
+      int addOutput(std::string_view name, uint32_t bitOffset, float scale, float offset, float min, float max);
+      // Builds the channel groups and selects the kernels for this CPU. An empty name selects the best one.
+      void bind(const std::string& kernel = "");
+      void clear();
+      const char* kernelName() const { return m_kernels ? m_kernels->name : "none"; }
+
+      // RT side
+      void readInputs(const uint8_t* inData);
+      void writeOutputs(uint8_t* outData);
+      float input(uint32_t channel) const { return m_inputs.value[m_inputs.slot[channel]]; }
+      void setOutput(uint32_t channel, float value) { m_outputs.value[m_outputs.slot[channel]] = value; }
+
+    private:
+      struct Group
+      {
+        uint32_t byteOffset; // first channel in the image
+        uint32_t first;      // first slot in the parameter arrays
+        uint32_t count;
+      };
+      struct Channels
+      {
+        std::vector<uint32_t> byteOffset; // in configuration order
+        std::vector<float> scale;         // scale for inputs, 1/scale for outputs
+        std::vector<float> offset;
+        std::vector<float> min;
+        std::vector<float> max;
+        std::vector<uint32_t> slot;       // configuration order -> position sorted by offset
+        std::vector<float> value;         // engineering values, sorted by offset
+        std::vector<Group> groups;
+        int add(uint32_t bitOffset, float scale, float offset, float min, float max);
+        void group();
+        void clear();
+      };
+
+      Channels m_inputs;
+      Channels m_outputs;
+      std::vector<int16_t> m_raw; // staging for groups that are not 2-byte aligned
+      const AnalogKernels* m_kernels = nullptr;
+  };
+}
@@ -1,7 +1,14 @@
 #include "rt_application.h"
 #include "Logger.h"
+#include <cstdlib>
+#include <fstream>
 
 namespace Example{
+RTApplication::~RTApplication(){
+  if(m_binder.joinable())
+    m_binder.join(); 
+}
+
 common::scheduler::SchedEventResponse RTApplication::execute(const common::scheduler::SchedEventType& eventType,
                                                             const common::scheduler::SchedEventPhase& eventPhase,
                                                             comm::datalayer::Variant& param)
@@ -11,91 +18,453 @@ common::scheduler::SchedEventResponse RTApplication::execute(const common::sched
   //if(eventType == common::scheduler::SchedEventType::SCHED_EVENT_TICK)
   case common::scheduler::SchedEventType::SCHED_EVENT_TICK:
   {
-    u_int8_t* inData; 
-    u_int8_t* outData; 
-    auto result = m_inputs->beginAccess(inData, m_inputRev); 
-    if(result == DL_OK)
+    //teardown waits for this tick before it releases what the tick uses, see quiesce
+    TickEpoch::Guard epoch(m_epoch); 
+    if(!m_bound.load(std::memory_order_seq_cst))
+      return common::scheduler::SchedEventResponse::SCHED_EVENT_RESP_OKAY; 
+    TimelineScope tick("execute"); 
+    //evicts the caches on the selected ticks of the WCET measurement
+    m_wcet.beginTick(); 
+    //a newly loaded user module takes over at the tick boundary
+    m_modules.switchModule(); 
+    m_shadow.switchModule(m_modules); 
+    //the newest complete parameter set is used from this tick on
+    if(m_parameters)
+      m_parameters->acquire(); 
+    //operator commands, a bounded number per tick
+    m_commands.drain(EtherCATUpdate::Command); 
+    m_wcet.mark(WcetPhase::Prepare); 
+    //copy the bound inputs of all sources, no memory is locked while the user code runs
+    bool inputs = m_image.readInputs(); 
+    m_wcet.mark(WcetPhase::Inputs); 
+    if(inputs)
     {
-      EtherCATUpdate::AT(inData, m_inMap);
+      const u_int8_t* inData = m_image.inputData(); 
+      m_analog.readInputs(inData);
+      //a candidate module in shadow mode runs on the same inputs, see bindMemory
+      m_shadow.AT(inData, [this](const u_int8_t* data){
+        TimelineScope scope("AT"); 
+        if(m_modules.active())
+          m_modules.AT(data); 
+        else
+          EtherCATUpdate::AT(data);
+      }); 
+      if(m_telemetry.update(inData) && m_workers)
+      {
+        m_workers->post(WorkItem{&RTApplication::reportTelemetry, this, 0}); 
+      }
+      m_scope.sample(ScopeImage::Input, inData);
     } 
     else
     {
       LOG_WARNING("Failed to open the input data!")
     } 
-    m_inputs->endAccess(); 
-    result = m_outputs->beginAccess(outData, m_outputRev);
-    if(result == comm::datalayer::DlResult::DL_OK)
-      { 
-        EtherCATUpdate::MDT(outData, m_outMap);
-      }
-    else
+    m_wcet.mark(WcetPhase::AT); 
+    //multi-tick procedures of the user code, between AT and MDT
+    m_sequencer.tick(); 
+    m_wcet.mark(WcetPhase::Sequences); 
+    u_int8_t* outData = m_image.outputData(); 
+    bool shadowWindow = m_shadow.MDT(outData, [this](u_int8_t* data){
+      TimelineScope scope("MDT"); 
+      if(m_modules.active())
+        m_modules.MDT(data); 
+      else
+        EtherCATUpdate::MDT(data);
+    }); 
+    //after the MDT, so the outputs of the block diagram replace the values the user code wrote
+    if(inputs)
+      m_diagram.execute(m_image.inputData(), outData); 
+    m_analog.writeOutputs(outData);
+    //timed writes of the user code due in this tick, after everything else that writes outputs
+    m_timers.advance(outData); 
+    //values for other RT apps, in the same tick as the MDT
+    m_publisher.publish(m_image.inputData()); 
+    m_wcet.mark(WcetPhase::MDT); 
+    m_scope.sample(ScopeImage::Output, outData);
+    if(!m_image.writeOutputs())
     {
       LOG_WARNING("Failed to open the output data!")
     }  
-    m_outputs->endAccess(); 
+    m_wcet.mark(WcetPhase::Outputs); 
+    m_export.publish(m_image); 
+    //copy of the retained state for the persistence thread
+    if(m_retained)
+      m_retained->capture(); 
+    if(m_scope.advance() && m_workers)
+    {
+      m_workers->post(WorkItem{&RTApplication::exportScope, this, 0}); 
+    }
+    if(shadowWindow && m_workers)
+    {
+      m_workers->post(WorkItem{&RTApplication::reportShadow, this, 0}); 
+    }
+    m_wcet.mark(WcetPhase::Finish); 
+    if(m_wcet.endTick() && m_workers)
+    {
+      m_workers->post(WorkItem{&RTApplication::reportCounters, this, 0}); 
+    }
     return common::scheduler::SchedEventResponse::SCHED_EVENT_RESP_OKAY;
   }
 
   case common::scheduler::SchedEventType::SCHED_EVENT_SWITCH_TO_SERVICE:
   {
-    m_outputs->endAccess();
-    m_inputs->endAccess(); 
+    //the memories are only accessed inside readInputs/writeOutputs, nothing is left open here
     return common::scheduler::SchedEventResponse::SCHED_EVENT_RESP_OKAY;
   }
   }
 }
 void RTApplication::setDatalyer(comm::datalayer::IDataLayerFactory3* datalayerFactory){
+  if(m_binder.joinable())
+    m_binder.join(); 
   m_datalayer = datalayerFactory; 
-  createClient(); 
-  openMemory(); 
+  //the callable is handed to the scheduler right away, its ticks idle until the memory is bound
+  m_binder = std::thread([this]{
+    createClient(); 
+    openMemory(); 
+  }); 
 }
 
 void RTApplication::resetDataLayer(){
+  if(m_binder.joinable())
+    m_binder.join(); 
   closeMemory(); 
   destroyClient(); 
   m_datalayer = nullptr; 
 }
 
+void RTApplication::quiesce(){
+  //a tick that starts from now on does nothing, the one that may still run is waited for
+  m_bound.store(false, std::memory_order_seq_cst); 
+  m_epoch.synchronize(); 
+  //the work the ticks posted runs on the state that is released next, e.g. the scope buffers
+  if(m_workers)
+    m_workers->drain(); 
+}
+
 void RTApplication::createClient(){
   m_client = m_datalayer->createClient3(DL_IPC_AUTO);
+  //registers the realtime data this app owns
+  m_provider = m_datalayer->createProvider(DL_IPC_AUTO); 
+  if(m_provider && m_provider->start() != DL_OK)
+  {
+    LOG_WARNING("Failed to start the provider of the realtime data"); 
+  }
+}
+
+bool RTApplication::readMap(const std::string& address, ImageMap& map, uint32_t& revision){
+  comm::datalayer::Variant dlMap; 
+  auto result = m_client->readSync(address, &dlMap); 
+  if(result != DL_OK)
+    return false; 
+  auto varMap = comm::datalayer::GetMemoryMap(dlMap.getData());
+  revision = varMap->revision(); 
+  map.reserve(varMap->variables()->size()); 
+  for(auto variables = varMap->variables()->begin(); variables!= varMap->variables()->end(); variables++){
+    map.insert(std::string_view(variables->name()->c_str(), variables->name()->size()), ImageVariable{variables->bitoffset(), variables->bitsize()}); 
+  }
+  map.sort(); 
+  return true; 
 }
 
 void RTApplication::openMemory(){
   if(m_client){
-    comm::datalayer::Variant dlMap; 
-    auto result = m_client->readSync("fieldbuses/ethercat/master/instances/ethercatmaster/realtime_data/input/map",&dlMap); 
-    auto varMap = comm::datalayer::GetMemoryMap(dlMap.getData());
-    m_inputRev = varMap->revision(); 
-    for(auto variables = varMap->variables()->begin(); variables!= varMap->variables()->end(); variables++){
-      m_inMap[variables->name()->str()] = variables->bitoffset(); 
+    std::vector<RealtimeSource> sources; 
+    for(auto& address : EtherCATUpdate::Sources()){
+      RealtimeSource source; 
+      source.prefix = address.prefix; 
+      if(readMap(address.address + "/input/map", source.inputMap, source.inputRevision))
+      {
+        if(m_datalayer->openMemory(source.inputs, address.address + "/input") != DL_OK)
+        {
+          LOG_WARNING("Failed to open %s/input", address.address.c_str()); 
+          source.inputs = nullptr; 
+          source.inputMap.clear(); 
+        }
+      }
+      if(readMap(address.address + "/output/map", source.outputMap, source.outputRevision))
+      {
+        if(m_datalayer->openMemory(source.outputs, address.address + "/output") != DL_OK)
+        {
+          LOG_WARNING("Failed to open %s/output", address.address.c_str()); 
+          source.outputs = nullptr; 
+          source.outputMap.clear(); 
+        }
+      }
+      if(!source.inputs && !source.outputs)
+      {
+        LOG_WARNING("No realtime data available at %s", address.address.c_str()); 
+        continue; 
+      }
+      sources.push_back(source); 
     }
-    result = m_datalayer->openMemory(m_inputs,"fieldbuses/ethercat/master/instances/ethercatmaster/realtime_data/input"); 
+    bindMemory(sources); 
+  }
+}
 
-    result = m_client->readSync("fieldbuses/ethercat/master/instances/ethercatmaster/realtime_data/output/map",&dlMap); 
-    varMap = comm::datalayer::GetMemoryMap(dlMap.getData());
-    m_outputRev = varMap->revision(); 
-    for(auto variables = varMap->variables()->begin(); variables!= varMap->variables()->end(); variables++){
-      m_outMap[variables->name()->str()] = variables->bitoffset(); 
+void RTApplication::bindMemory(const std::vector<RealtimeSource>& sources){
+  m_sources = sources; 
+  m_image.bind(m_sources); 
+  loadParameters(); 
+  EtherCATUpdate::Bind(m_image); 
+  loadRetained(); 
+  EtherCATUpdate::Sequences(m_sequencer); 
+  loadDiagram(); 
+  EtherCATUpdate::Telemetry(m_telemetry, m_image); 
+  EtherCATUpdate::Scope(m_scope, m_image); 
+  EtherCATUpdate::Analog(m_analog, m_image); 
+  EtherCATUpdate::Timers(m_timers, m_image); 
+  //SDK_EXAMPLE_ANALOG_KERNEL=scalar|sse4.1|avx2|neon forces an implementation
+  const char* kernel = std::getenv("SDK_EXAMPLE_ANALOG_KERNEL"); 
+  m_analog.bind(kernel ? kernel : ""); 
+  m_image.finalize(); 
+  //SDK_EXAMPLE_EXPORT names the shared-memory segment of the image export, "off" disables it
+  const char* segment = std::getenv("SDK_EXAMPLE_EXPORT"); 
+  if(!segment || std::string(segment) != "off")
+  {
+    EtherCATUpdate::Export(m_export, m_image); 
+    m_export.open(segment ? segment : EXPORT_DEFAULT_NAME, m_image); 
+  }
+  //SDK_EXAMPLE_REALTIME_DATA is the address of the realtime data this app owns, "off" disables it
+  const char* realtimeData = std::getenv("SDK_EXAMPLE_REALTIME_DATA"); 
+  if(m_datalayer && (!realtimeData || std::string(realtimeData) != "off"))
+  {
+    EtherCATUpdate::Publish(m_publisher, m_image); 
+    std::string address = realtimeData ? realtimeData : PUBLISH_DEFAULT_ADDRESS; 
+    if(!m_publisher.empty() && !m_publisher.create(m_datalayer, m_provider, address))
+    {
+      LOG_WARNING("Values of the user code not published at %s", address.c_str()); 
     }
-    result = m_datalayer->openMemory(m_outputs,"fieldbuses/ethercat/master/instances/ethercatmaster/realtime_data/output");
   }
+  //SDK_EXAMPLE_MODULE selects the user logic module, otherwise $SNAP_COMMON/logic.so; it is loaded whenever the file changes
+  const char* module = std::getenv("SDK_EXAMPLE_MODULE"); 
+  const char* directory = std::getenv("SNAP_COMMON"); 
+  m_modules.watch(module ? module : std::string(directory ? directory : "/tmp") + "/logic.so", m_image); 
+  //SDK_EXAMPLE_SHADOW selects a candidate module that runs in shadow mode next to the active logic, its outputs are discarded
+  const char* shadow = std::getenv("SDK_EXAMPLE_SHADOW"); 
+  if(shadow)
+    m_shadow.watch(shadow, m_image); 
+  //SDK_EXAMPLE_WCET=N runs every N-th tick with cold caches and logs the times of the tick phases when unbound; not for production
+  const char* wcet = std::getenv("SDK_EXAMPLE_WCET"); 
+  if(wcet)
+    m_wcet.enable(std::strtoul(wcet, nullptr, 10)); 
+  //SDK_EXAMPLE_COUNTERS=N sums time and hardware counters of the tick phases over windows of N ticks and logs them
+  const char* counters = std::getenv("SDK_EXAMPLE_COUNTERS"); 
+  if(counters)
+    m_wcet.enableCounters(std::strtoul(counters, nullptr, 10)); 
+  //SDK_EXAMPLE_TIMELINE is the file of the execution timeline in the Chrome trace format; not for production
+  const char* timeline = std::getenv("SDK_EXAMPLE_TIMELINE"); 
+  if(timeline && !Timeline::start(timeline))
+  {
+    LOG_WARNING("Timeline %s not created", timeline); 
+  }
+  //the next tick runs on the bound memory
+  m_bound.store(true, std::memory_order_seq_cst); 
 }
 
-void RTApplication::closeMemory(){
-  if(m_inputs){
-    m_datalayer->closeMemory(m_inputs); 
-    m_inputs = nullptr; 
+void RTApplication::unbindMemory(){
+  quiesce(); 
+  reportWcet(); 
+  m_wcet.disableCounters(); 
+  if(Timeline::enabled())
+  {
+    Timeline::stop(); 
+    LOG_INFO("Timeline written, %llu sections dropped", (unsigned long long)Timeline::dropped()); 
+  }
+  //stores the state of the last tick
+  m_persistence.close(); 
+  m_retained = nullptr; 
+  m_shadow.unload(); 
+  m_modules.unload(); 
+  m_parameterWatch.stop(); 
+  m_parameters = nullptr; 
+  m_sequencer.clear(); 
+  m_export.close(); 
+  m_publisher.destroy(); 
+  m_diagram.clear(); 
+  m_telemetry.clear(); 
+  m_scope.clear(); 
+  m_analog.clear(); 
+  m_timers.clear(); 
+  m_image.clear(); 
+  m_sources.clear(); 
+}
+
+void RTApplication::loadParameters(){
+  m_parameters = EtherCATUpdate::Parameters(); 
+  if(!m_parameters)
+    return; 
+  //SDK_EXAMPLE_PARAMETERS selects the parameter file, otherwise $SNAP_COMMON/parameters.txt; it is applied whenever it changes
+  const char* configured = std::getenv("SDK_EXAMPLE_PARAMETERS"); 
+  const char* directory = std::getenv("SNAP_COMMON"); 
+  std::string path = configured ? configured : std::string(directory ? directory : "/tmp") + "/parameters.txt"; 
+  std::string error; 
+  if(std::ifstream(path) && !m_parameters->load(path, error))
+  {
+    LOG_ERROR("Parameters %s not applied: %s", path.c_str(), error.c_str())
+  }
+  IParameterStore* parameters = m_parameters; 
+  m_parameterWatch.start(path, [parameters](const std::string& changed){
+    std::string error; 
+    if(parameters->load(changed, error))
+    {
+      LOG_INFO("Parameters %s applied", changed.c_str())
+    }
+    else
+    {
+      LOG_ERROR("Parameters %s not applied: %s", changed.c_str(), error.c_str())
+    }
+  }); 
+}
+
+void RTApplication::loadRetained(){
+  m_retained = EtherCATUpdate::Retained(); 
+  //SDK_EXAMPLE_RETAINED selects the file of the retained state, otherwise $SNAP_COMMON/retained.bin; "off" disables it
+  const char* configured = std::getenv("SDK_EXAMPLE_RETAINED"); 
+  if(!m_retained || (configured && std::string(configured) == "off"))
+  {
+    m_retained = nullptr; 
+    return; 
+  }
+  const char* directory = std::getenv("SNAP_COMMON"); 
+  std::string path = configured ? configured : std::string(directory ? directory : "/tmp") + "/retained.bin"; 
+  std::string error; 
+  if(m_persistence.open(path, *m_retained, error))
+  {
+    LOG_INFO("Retained state restored from %s", path.c_str())
+  }
+  else if(m_persistence.isOpen())
+  {
+    LOG_WARNING("Retained state not restored from %s: %s", path.c_str(), error.c_str())
+  }
+  else
+  {
+    LOG_ERROR("Retained state not kept in %s: %s", path.c_str(), error.c_str())
+    m_retained = nullptr; 
+    return; 
+  }
+  //SDK_EXAMPLE_RETAINED_INTERVAL is the time in ms between two flushes of the state to the file
+  const char* interval = std::getenv("SDK_EXAMPLE_RETAINED_INTERVAL"); 
+  m_persistence.start(interval ? std::strtoul(interval, nullptr, 10) : 1000); 
+}
+
+void RTApplication::reportWcet(){
+  if(!m_wcet.enabled())
+    return; 
+  m_wcet.disable(); 
+  for(bool cold : {true, false}){
+    for(auto& phase : m_wcet.statistics(cold)){
+      LOG_INFO("WCET %s %s: %zu samples, p50 %u ns, p99 %u ns, p99.9 %u ns, max %u ns", cold ? "cold" : "warm", phase.phase, 
+               phase.samples, phase.p50, phase.p99, phase.p999, phase.max)
+    }
   }
-  if(m_outputs){
-    m_datalayer->closeMemory(m_outputs); 
-    m_outputs = nullptr;
+}
+
+void RTApplication::reportCounters(void* context, uint64_t argument){
+  auto application = static_cast<RTApplication*>(context); 
+  CounterWindow window; 
+  while(application->m_wcet.poll(window)){
+    for(size_t phase = 0; phase < WCET_PHASES; phase++){
+      const PhaseCounts& counts = window.phases[phase]; 
+      double ticks = window.ticks; 
+      if(!window.counters)
+      {
+        LOG_INFO("Counters %s: %.0f ns per tick over %u ticks, timing only", wcetPhaseName(WcetPhase(phase)), counts.nanoseconds/ticks, window.ticks)
+        continue; 
+      }
+      double cycles = counts.counts[size_t(PerfCounter::Cycles)]; 
+      double instructions = counts.counts[size_t(PerfCounter::Instructions)]; 
+      LOG_INFO("Counters %s: %.0f ns, %.0f cycles, %.0f instructions (IPC %.2f), %.1f cache misses, %.1f branch misses per tick over %u ticks", 
+               wcetPhaseName(WcetPhase(phase)), counts.nanoseconds/ticks, cycles/ticks, instructions/ticks, cycles ? instructions/cycles : 0.0, 
+               counts.counts[size_t(PerfCounter::CacheMisses)]/ticks, counts.counts[size_t(PerfCounter::BranchMisses)]/ticks, window.ticks)
+    }
   }
 }
 
+void RTApplication::loadDiagram(){
+  //SDK_EXAMPLE_DIAGRAM selects the block diagram file, otherwise $SNAP_COMMON/diagram.txt is used if it exists
+  const char* configured = std::getenv("SDK_EXAMPLE_DIAGRAM"); 
+  const char* directory = std::getenv("SNAP_COMMON"); 
+  std::string path = configured ? configured : std::string(directory ? directory : "/tmp") + "/diagram.txt"; 
+  if(!configured && !std::ifstream(path))
+    return; 
+  std::string error; 
+  if(!m_diagram.load(path, m_image, error))
+  {
+    LOG_ERROR("Block diagram %s not loaded: %s", path.c_str(), error.c_str()); 
+    return; 
+  }
+  LOG_INFO("Block diagram %s: %zu blocks compiled to %zu instructions", path.c_str(), m_diagram.blockCount(), m_diagram.instructionCount()); 
+}
+
+void RTApplication::closeMemory(){
+  quiesce(); 
+  if(m_datalayer){
+    for(auto& source : m_sources){
+      if(source.inputs)
+        m_datalayer->closeMemory(source.inputs); 
+      if(source.outputs)
+        m_datalayer->closeMemory(source.outputs); 
+    }
+  }
+  unbindMemory(); 
+}
+
 void RTApplication::destroyClient(){
+  if(m_provider)
+  {
+    m_provider->stop(); 
+    delete m_provider; 
+    m_provider = nullptr; 
+  }
   if(m_client)
+  {
     delete m_client; 
+    m_client = nullptr; 
+  }
 }
 
 
-}
\ No newline at end of file
+void RTApplication::exportScope(void* context, uint64_t argument){
+  auto application = static_cast<RTApplication*>(context); 
+  const char* directory = std::getenv("SNAP_COMMON"); 
+  std::string path = std::string(directory ? directory : "/tmp") + "/scope.csv"; 
+  std::ofstream file(path); 
+  application->m_scope.exportCsv(file); 
+  LOG_INFO("Scope capture written to %s", path.c_str()); 
+  application->m_scope.arm(); 
+}
+
+void RTApplication::reportTelemetry(void* context, uint64_t argument){
+  auto application = static_cast<RTApplication*>(context); 
+  TelemetryAggregator& telemetry = application->m_telemetry; 
+  TelemetryWindow window; 
+  while(telemetry.poll(window)){
+    for(uint32_t channel = 0; channel < window.channels; channel++){
+      LOG_INFO("Telemetry %s window %llu: min %g, max %g, mean %g, rms %g over %u ticks", telemetry.channelName(channel).c_str(), 
+               (unsigned long long)window.sequence, window.min[channel], window.max[channel], window.mean[channel], window.rms[channel], window.samples)
+    }
+  }
+}
+
+void RTApplication::reportShadow(void* context, uint64_t argument){
+  auto application = static_cast<RTApplication*>(context); 
+  std::string candidate = application->m_shadow.candidateName(); 
+  ShadowReport report; 
+  while(application->m_shadow.poll(report)){
+    double activeMean = double(report.activeSumNs)/report.ticks; 
+    double candidateMean = double(report.candidateSumNs)/report.ticks; 
+    if(report.divergentTicks)
+    {
+      LOG_WARNING("Shadow %s: outputs differ in %u of %u ticks (%llu bytes, first at offset %d), active mean/max %.0f/%llu ns, candidate %.0f/%llu ns", 
+                  candidate.c_str(), report.divergentTicks, report.ticks, (unsigned long long)report.divergentBytes, report.firstDivergence, 
+                  activeMean, (unsigned long long)report.activeMaxNs, candidateMean, (unsigned long long)report.candidateMaxNs)
+    }
+    else
+    {
+      LOG_INFO("Shadow %s: outputs equal in %u ticks, active mean/max %.0f/%llu ns, candidate %.0f/%llu ns", 
+               candidate.c_str(), report.ticks, activeMean, (unsigned long long)report.activeMaxNs, candidateMean, (unsigned long long)report.candidateMaxNs)
+    }
+  }
+}
+
+}
@@ -1,34 +1,96 @@
 #pragma once
 #include "comm/datalayer/datalayer.h"
 #include "common/scheduler/i_scheduler3.h"
-#include <map> 
 #include "../User/EtherCATUpdates.h"
+#include "rt_process_image.h"
+#include "rt_telemetry.h"
+#include "rt_scope.h"
+#include "rt_analog.h"
+#include "rt_diagram.h"
+#include "rt_user_module.h"
+#include "rt_export.h"
+#include "rt_publisher.h"
+#include "rt_commands.h"
+#include "rt_sequencer.h"
+#include "rt_shadow.h"
+#include "rt_timer_wheel.h"
+#include "rt_wcet.h"
+#include "rt_timeline.h"
+#include "rt_epoch.h"
+#include "rt_file_watcher.h"
+#include "rt_parameters.h"
+#include "rt_retained.h"
+#include "worker_pool.h"
 
 namespace Example{
   class RTApplication:public common::scheduler::ICallable
   {
     public:
+      ~RTApplication(); 
       common::scheduler::SchedEventResponse execute(const common::scheduler::SchedEventType& eventType,
                                                     const common::scheduler::SchedEventPhase& eventPhase,
                                                     comm::datalayer::Variant& param); 
       void setDatalyer(comm::datalayer::IDataLayerFactory3* datalayerFactory);
       void resetDataLayer();
+      void setWorkerPool(WorkerPool* workers) { m_workers = workers; }
+      // Binds already opened memories, e.g. the in-process images of the host-side tick driver
+      void bindMemory(const std::vector<RealtimeSource>& sources);
+      void unbindMemory();
+      TelemetryAggregator& telemetry() { return m_telemetry; }
+      Oscilloscope& scope() { return m_scope; }
+      // Operator commands from any non-RT thread, executed at the start of the next ticks
+      CommandQueue& commands() { return m_commands; }
+      // Output writes at future ticks, scheduled by the user code
+      TimerWheel& timers() { return m_timers; }
+      // Candidate logic in shadow mode, SDK_EXAMPLE_SHADOW
+      ShadowRunner& shadow() { return m_shadow; }
+      // Cold-start timing of the tick phases, SDK_EXAMPLE_WCET, and their hardware counters, SDK_EXAMPLE_COUNTERS
+      WcetProbe& wcet() { return m_wcet; }
         
     private: 
-      comm::datalayer::IDataLayerFactory3* m_datalayer;
-      comm::datalayer::IClient3* m_client; 
-      std::shared_ptr<comm::datalayer::IMemoryUser> m_inputs; 
-      std::shared_ptr<comm::datalayer::IMemoryUser> m_outputs;  
-      uint32_t m_inputRev; 
-      uint32_t m_outputRev; 
+      comm::datalayer::IDataLayerFactory3* m_datalayer = nullptr;
+      comm::datalayer::IClient3* m_client = nullptr; 
+      comm::datalayer::IProvider* m_provider = nullptr; 
+      std::vector<RealtimeSource> m_sources; 
       //int m_ticks = 0; 
-      std::map<std::string,uint32_t> m_inMap; 
-      std::map<std::string,uint32_t> m_outMap; 
+      ProcessImage m_image; 
+      TelemetryAggregator m_telemetry; 
+      Oscilloscope m_scope; 
+      AnalogConverter m_analog; 
+      BlockDiagram m_diagram; 
+      UserModuleHost m_modules; 
+      ShadowRunner m_shadow; 
+      ImageExporter m_export; 
+      RealtimePublisher m_publisher; 
+      IParameterStore* m_parameters = nullptr; 
+      FileWatcher m_parameterWatch; 
+      IRetainedState* m_retained = nullptr; 
+      StatePersistence m_persistence; 
+      CommandQueue m_commands; 
+      Sequencer m_sequencer; 
+      TimerWheel m_timers; 
+      WcetProbe m_wcet; 
+      WorkerPool* m_workers = nullptr; 
+      //set once the memory is bound; cleared and waited for through the epoch before it is released
+      std::atomic<bool> m_bound{false}; 
+      TickEpoch m_epoch; 
+      //binds in the background after the Data Layer was set
+      std::thread m_binder; 
       void createClient(); 
       void openMemory(); 
       void closeMemory(); 
       void destroyClient(); 
+      void quiesce(); 
+      void loadDiagram(); 
+      void loadParameters(); 
+      void loadRetained(); 
+      void reportWcet(); 
+      bool readMap(const std::string& address, ImageMap& map, uint32_t& revision); 
+      static void exportScope(void* context, uint64_t argument); 
+      static void reportTelemetry(void* context, uint64_t argument); 
+      static void reportShadow(void* context, uint64_t argument); 
+      static void reportCounters(void* context, uint64_t argument); 
 
       
   };
-}
\ No newline at end of file
+}
@@ -58,4 +58,8 @@ void RTApplicationFactory::resetDataLayer(){
   m_dataLayer = nullptr; 
 }
 
+void RTApplicationFactory::setWorkerPool(WorkerPool* workers){
+  m_application->setWorkerPool(workers); 
+}
+
 }
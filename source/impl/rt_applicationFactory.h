@@ -14,6 +14,7 @@ namespace Example{
       void getCallableConfigurations(comm::datalayer::Variant& configurations) const;
       void setDataLayer(comm::datalayer::IDataLayerFactory3* dataLayer); 
       void resetDataLayer(); 
+      void setWorkerPool(WorkerPool* workers); 
 
     private: 
       std::shared_ptr<RTApplication> m_application = std::make_shared<RTApplication>(); 
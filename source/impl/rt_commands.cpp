@@ -0,0 +1,64 @@
+#include "rt_commands.h"
+#include <algorithm>
+#include <thread>
+
+namespace Example{
+namespace {
+  // the issuer polls the slot, the tick never wakes anybody up
+  constexpr auto FIRST_POLL = std::chrono::microseconds(20);
+  constexpr auto LAST_POLL = std::chrono::microseconds(1000);
+}
+
+CommandQueue::CommandQueue(){
+  for(uint32_t index = 0; index < CAPACITY; index++)
+    m_free.push(index);
+}
+
+void CommandQueue::release(uint32_t index){
+  m_slots[index].state.store(Free, std::memory_order_relaxed);
+  m_free.push(index);
+}
+
+bool CommandQueue::submit(const Command& command, CommandTicket& ticket){
+  uint32_t index;
+  if(!m_free.pop(index)){
+    m_rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  Slot& slot = m_slots[index];
+  slot.generation++;
+  slot.command = command;
+  slot.state.store(Queued, std::memory_order_relaxed);
+  // there are never more queued commands than slots, the push cannot fail
+  m_pending.push(index);
+  ticket = CommandTicket{index, slot.generation};
+  return true;
+}
+
+bool CommandQueue::wait(const CommandTicket& ticket, CommandResult& result, std::chrono::microseconds timeout){
+  if(ticket.slot >= CAPACITY || m_slots[ticket.slot].generation != ticket.generation)
+    return false;
+  Slot& slot = m_slots[ticket.slot];
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  auto poll = FIRST_POLL;
+  while(slot.state.load(std::memory_order_acquire) != Done){
+    if(std::chrono::steady_clock::now() >= deadline){
+      uint32_t expected = Queued;
+      if(slot.state.compare_exchange_strong(expected, Abandoned, std::memory_order_acq_rel))
+        return false;
+      // completed in the meantime
+      break;
+    }
+    std::this_thread::sleep_for(poll);
+    poll = std::min(poll*2, LAST_POLL);
+  }
+  result = slot.result;
+  release(ticket.slot);
+  return true;
+}
+
+bool CommandQueue::execute(const Command& command, CommandResult& result, std::chrono::microseconds timeout){
+  CommandTicket ticket;
+  return submit(command, ticket) && wait(ticket, result, timeout);
+}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "rt_mpmc_queue.h"
+
+namespace Example{
+  // Operator action for the user code, e.g. enable an axis; codes are defined by the handler
+  struct Command
+  {
+    uint32_t code = 0;
+    uint32_t target = 0;
+    int64_t argument = 0;
+  };
+
+  struct CommandResult
+  {
+    int32_t status = 0;   // 0: executed, other values are defined by the handler
+    int64_t value = 0;
+  };
+
+  struct CommandTicket
+  {
+    uint32_t slot = 0;
+    uint32_t generation = 0;
+  };
+
+  // Commands from any number of non-RT threads into the tick. A command occupies one of CAPACITY completion
+  // slots from submit() until its result is collected with wait(); the tick executes queued commands at its
+  // start, at most budget per tick, and completes the slot with a single store. Nothing blocks the tick,
+  // an issuer that gives up leaves the slot to be released by the tick.
+  class CommandQueue
+  {
+    public:
+      static constexpr size_t CAPACITY = 256;
+      static constexpr uint32_t DRAIN_BUDGET = 16;
+
+      CommandQueue();
+
+      // Non-RT, any thread. submit() fails when all slots are in use.
+      bool submit(const Command& command, CommandTicket& ticket);
+      // False if the command was not executed within the timeout, its result is dropped then
+      bool wait(const CommandTicket& ticket, CommandResult& result, std::chrono::microseconds timeout);
+      bool execute(const Command& command, CommandResult& result, std::chrono::microseconds timeout);
+      uint64_t executed() const { return m_executed.load(std::memory_order_relaxed); }
+      uint64_t rejected() const { return m_rejected.load(std::memory_order_relaxed); }
+
+      // RT side, handler: CommandResult(const Command&). Returns the number of commands executed.
+      template<typename Handler>
+      uint32_t drain(Handler&& handler, uint32_t budget = DRAIN_BUDGET){
+        uint32_t count = 0;
+        uint32_t index;
+        while(count < budget && m_pending.pop(index)){
+          Slot& slot = m_slots[index];
+          slot.result = handler(slot.command);
+          uint32_t expected = Queued;
+          if(!slot.state.compare_exchange_strong(expected, Done, std::memory_order_acq_rel))
+            release(index);
+          count++;
+        }
+        if(count)
+          m_executed.fetch_add(count, std::memory_order_relaxed);
+        return count;
+      }
+
+    private:
+      enum SlotState : uint32_t
+      {
+        Free,
+        Queued,
+        Done,
+        Abandoned
+      };
+
+      struct alignas(64) Slot
+      {
+        std::atomic<uint32_t> state{Free};
+        uint32_t generation = 0;
+        Command command;
+        CommandResult result;
+      };
+
+      void release(uint32_t index);
+
+      std::array<Slot, CAPACITY> m_slots;
+      MpmcQueue<uint32_t, CAPACITY> m_free;
+      MpmcQueue<uint32_t, CAPACITY> m_pending;
+      std::atomic<uint64_t> m_executed{0};
+      std::atomic<uint64_t> m_rejected{0};
+  };
+}
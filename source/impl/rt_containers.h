@@ -0,0 +1,272 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Example{
+  // Fixed-capacity containers for RT state. Their storage is either part of the object or allocated once
+  // while binding; nothing grows in the tick, operations that would need more room fail instead.
+
+  // Vector with inline storage for N elements
+  template<typename T, size_t N>
+  class StaticVector
+  {
+    public:
+      StaticVector() = default;
+      StaticVector(const StaticVector& other) { for(auto& item : other) push_back(item); }
+      StaticVector& operator=(const StaticVector& other){
+        if(this != &other){
+          clear();
+          for(auto& item : other)
+            push_back(item);
+        }
+        return *this;
+      }
+      ~StaticVector() { clear(); }
+
+      bool push_back(const T& item){
+        if(m_size == N)
+          return false;
+        new (&m_storage[m_size*sizeof(T)]) T(item);
+        m_size++;
+        return true;
+      }
+      void pop_back() { data()[--m_size].~T(); }
+      // Removes the element by moving the last one into its place
+      void swapErase(size_t index){
+        if(index != m_size - 1)
+          data()[index] = std::move(data()[m_size - 1]);
+        pop_back();
+      }
+      void clear() { while(m_size) pop_back(); }
+
+      T* data() { return std::launder(reinterpret_cast<T*>(m_storage)); }
+      const T* data() const { return std::launder(reinterpret_cast<const T*>(m_storage)); }
+      T& operator[](size_t index) { return data()[index]; }
+      const T& operator[](size_t index) const { return data()[index]; }
+      T* begin() { return data(); }
+      T* end() { return data() + m_size; }
+      const T* begin() const { return data(); }
+      const T* end() const { return data() + m_size; }
+      size_t size() const { return m_size; }
+      bool empty() const { return m_size == 0; }
+      bool full() const { return m_size == N; }
+      static constexpr size_t capacity() { return N; }
+
+    private:
+      alignas(T) unsigned char m_storage[N*sizeof(T)];
+      size_t m_size = 0;
+  };
+
+  // Map from names to values in one sorted array, looked up by binary search with string_view keys.
+  // The names are kept in blocks that never move, so the keys of the entries stay valid.
+  // Entries added in key order keep the map sorted, otherwise sort() is called after the last insert.
+  template<typename V>
+  class FlatMap
+  {
+    public:
+      struct Entry
+      {
+        std::string_view first;
+        V second;
+      };
+      typedef const Entry* const_iterator;
+
+      FlatMap() = default;
+      FlatMap(std::initializer_list<std::pair<std::string_view, V>> entries){
+        for(auto& entry : entries)
+          insert(entry.first, entry.second);
+        sort();
+      }
+      FlatMap(const FlatMap& other) { *this = other; }
+      FlatMap(FlatMap&& other) noexcept { *this = std::move(other); }
+      FlatMap& operator=(const FlatMap& other){
+        if(this != &other){
+          clear();
+          reserve(other.size());
+          for(auto& entry : other)
+            insert(entry.first, entry.second);
+          m_sorted = other.m_sorted;
+        }
+        return *this;
+      }
+      // The blocks move with the entries, so their keys stay valid; the source is left empty and usable
+      FlatMap& operator=(FlatMap&& other) noexcept{
+        if(this != &other){
+          m_entries = std::move(other.m_entries);
+          m_blocks = std::move(other.m_blocks);
+          m_used = other.m_used;
+          m_sorted = other.m_sorted;
+          other.clear();
+        }
+        return *this;
+      }
+
+      void reserve(size_t entries) { m_entries.reserve(entries); }
+      // Non-RT; a key that exists already gets the new value once the map is sorted
+      void insert(std::string_view key, const V& value){
+        if(m_sorted && !m_entries.empty()){
+          Entry& last = m_entries.back();
+          if(key == last.first){
+            last.second = value;
+            return;
+          }
+          if(key < last.first)
+            m_sorted = false;
+        }
+        m_entries.push_back(Entry{store(key), value});
+      }
+      // Orders the entries by key, the last value of a duplicate key wins
+      void sort(){
+        if(m_sorted)
+          return;
+        std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b){ return a.first < b.first; });
+        size_t kept = 0;
+        for(size_t index = 0; index < m_entries.size(); index++){
+          if(kept && m_entries[kept - 1].first == m_entries[index].first)
+            m_entries[kept - 1].second = m_entries[index].second;
+          else
+            m_entries[kept++] = m_entries[index];
+        }
+        m_entries.resize(kept);
+        m_sorted = true;
+      }
+      void clear(){
+        m_entries.clear();
+        m_blocks.clear();
+        m_used = BLOCK_SIZE;
+        m_sorted = true;
+      }
+
+      const_iterator find(std::string_view key) const{
+        if(!m_sorted){
+          for(auto& entry : m_entries)
+            if(entry.first == key)
+              return &entry;
+          return end();
+        }
+        auto entry = std::lower_bound(begin(), end(), key, [](const Entry& a, std::string_view b){ return a.first < b; });
+        return entry != end() && entry->first == key ? entry : end();
+      }
+      const V& at(std::string_view key) const{
+        auto entry = find(key);
+        if(entry == end())
+          throw std::out_of_range("FlatMap::at");
+        return entry->second;
+      }
+      bool contains(std::string_view key) const { return find(key) != end(); }
+
+      const_iterator begin() const { return m_entries.data(); }
+      const_iterator end() const { return m_entries.data() + m_entries.size(); }
+      size_t size() const { return m_entries.size(); }
+      bool empty() const { return m_entries.empty(); }
+
+    private:
+      static constexpr size_t BLOCK_SIZE = 16384;
+
+      std::string_view store(std::string_view key){
+        if(key.size() > BLOCK_SIZE - m_used){
+          m_blocks.emplace_back(new char[std::max(BLOCK_SIZE, key.size())]);
+          m_used = 0;
+        }
+        char* target = m_blocks.back().get() + m_used;
+        if(!key.empty())
+          std::memcpy(target, key.data(), key.size());
+        m_used += key.size();
+        return std::string_view(target, key.size());
+      }
+
+      std::vector<Entry> m_entries;
+      std::vector<std::unique_ptr<char[]>> m_blocks;
+      size_t m_used = BLOCK_SIZE;
+      bool m_sorted = true;
+  };
+
+  // Link of an intrusive ring: objects embed one RingLink per ring they can be in, a ring never allocates.
+  // An unlinked link points to itself; the head of a ring is a RingLink that is not part of an object.
+  struct RingLink
+  {
+    RingLink* next = this;
+    RingLink* previous = this;
+
+    RingLink() = default;
+    RingLink(const RingLink&) : RingLink() {}
+    RingLink& operator=(const RingLink&) { return *this; }
+
+    bool linked() const { return next != this; }
+    void unlink(){
+      next->previous = previous;
+      previous->next = next;
+      next = previous = this;
+    }
+    // Inserts this link before position, i.e. at the back when position is the head
+    void linkBefore(RingLink& position){
+      unlink();
+      next = &position;
+      previous = position.previous;
+      previous->next = this;
+      position.previous = this;
+    }
+  };
+
+  template<typename T, RingLink T::*Link>
+  class IntrusiveRing
+  {
+    public:
+      IntrusiveRing() = default;
+      IntrusiveRing(const IntrusiveRing&) = delete;
+      IntrusiveRing& operator=(const IntrusiveRing&) = delete;
+      ~IntrusiveRing() { clear(); }
+
+      void pushBack(T& item) { (item.*Link).linkBefore(m_head); }
+      void pushFront(T& item) { (item.*Link).linkBefore(*m_head.next); }
+      static void remove(T& item) { (item.*Link).unlink(); }
+      T* front() { return empty() ? nullptr : owner(m_head.next); }
+      T* popFront(){
+        T* item = front();
+        if(item)
+          remove(*item);
+        return item;
+      }
+      bool empty() const { return !m_head.linked(); }
+      void clear() { while(!empty()) m_head.next->unlink(); }
+      // Moves all items of other to the back of this ring
+      void splice(IntrusiveRing& other){
+        if(other.empty())
+          return;
+        RingLink* first = other.m_head.next;
+        RingLink* last = other.m_head.previous;
+        other.m_head.next = other.m_head.previous = &other.m_head;
+        first->previous = m_head.previous;
+        m_head.previous->next = first;
+        last->next = &m_head;
+        m_head.previous = last;
+      }
+
+      // Visits every item; the visitor may remove the item it gets
+      template<typename Visitor>
+      void forEach(Visitor&& visitor){
+        for(RingLink* link = m_head.next; link != &m_head;){
+          RingLink* next = link->next;
+          visitor(*owner(link));
+          link = next;
+        }
+      }
+
+    private:
+      static T* owner(RingLink* link){
+        auto offset = reinterpret_cast<size_t>(&(static_cast<T*>(nullptr)->*Link));
+        return reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(link) - offset);
+      }
+
+      RingLink m_head;
+  };
+}
@@ -0,0 +1,365 @@
+#include "rt_control.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+namespace Example{
+namespace {
+  // Grows the lane arrays for one more instance, new lanes are zero
+  template<typename Lanes>
+  void grow(uint32_t count, std::initializer_list<std::vector<Lanes>*> arrays){
+    size_t blocks = (count + CONTROL_LANES - 1)/CONTROL_LANES;
+    for(auto array : arrays)
+      array->resize(blocks, Lanes{});
+  }
+
+  template<typename Lanes>
+  void zero(std::initializer_list<std::vector<Lanes>*> arrays){
+    for(auto array : arrays)
+      std::fill(array->begin(), array->end(), Lanes{});
+  }
+
+  template<typename Lanes>
+  void release(std::initializer_list<std::vector<Lanes>*> arrays){
+    for(auto array : arrays)
+      array->clear();
+  }
+
+  inline ControlLanes clamp(ControlLanes value, ControlLanes min, ControlLanes max){
+    value = value < max ? value : max;
+    return value > min ? value : min;
+  }
+
+  // divides by a0, the designs below return the cookbook coefficients unnormalized
+  BiquadCoefficients normalize(double b0, double b1, double b2, double a0, double a1, double a2){
+    BiquadCoefficients coefficients;
+    coefficients.b0 = b0/a0;
+    coefficients.b1 = b1/a0;
+    coefficients.b2 = b2/a0;
+    coefficients.a1 = a1/a0;
+    coefficients.a2 = a2/a0;
+    return coefficients;
+  }
+
+  bool toFixed(double value, int32_t& fixed){
+    double scaled = std::nearbyint(value*(1 << FixedBiquadBank::FRACTION_BITS));
+    if(scaled >= 2147483648.0 || scaled < -2147483648.0)
+      return false;
+    fixed = static_cast<int32_t>(scaled);
+    return true;
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// PID
+
+int PidBank::add(const PidParameters& parameters, float cycleTime){
+  if(cycleTime <= 0.0f || parameters.min > parameters.max)
+    return -1;
+  uint32_t index = m_count++;
+  grow<ControlLanes>(m_count, {&m_kp, &m_ki, &m_decay, &m_kd, &m_kaw, &m_min, &m_max, &m_integral, &m_derivative,
+                               &m_previous, &m_setpoint, &m_measurement, &m_output});
+
+  float trackingTime = parameters.trackingTime;
+  if(trackingTime <= 0.0f && parameters.ki > 0.0f)
+    trackingTime = parameters.kd > 0.0f ? std::sqrt(parameters.kd/parameters.ki) : parameters.kp/parameters.ki;
+  float filter = std::max(parameters.derivativeFilter, 0.0f);
+
+  uint32_t block = index/CONTROL_LANES;
+  uint32_t lane = index%CONTROL_LANES;
+  m_kp[block][lane] = parameters.kp;
+  m_ki[block][lane] = parameters.ki*cycleTime;
+  m_decay[block][lane] = filter/(filter + cycleTime);
+  m_kd[block][lane] = parameters.kd/(filter + cycleTime);
+  m_kaw[block][lane] = trackingTime > 0.0f ? std::min(cycleTime/trackingTime, 1.0f) : 0.0f;
+  m_min[block][lane] = parameters.min;
+  m_max[block][lane] = parameters.max;
+  return static_cast<int>(index);
+}
+
+void PidBank::clear(){
+  m_count = 0;
+  release<ControlLanes>({&m_kp, &m_ki, &m_decay, &m_kd, &m_kaw, &m_min, &m_max, &m_integral, &m_derivative,
+                         &m_previous, &m_setpoint, &m_measurement, &m_output});
+}
+
+void PidBank::reset(){
+  zero<ControlLanes>({&m_integral, &m_derivative, &m_output});
+  m_previous = m_measurement;
+}
+
+void PidBank::update(){
+  for(size_t block = 0; block < m_kp.size(); block++){
+    ControlLanes measurement = m_measurement[block];
+    ControlLanes error = m_setpoint[block] - measurement;
+    ControlLanes derivative = m_decay[block]*m_derivative[block] + m_kd[block]*(m_previous[block] - measurement);
+    ControlLanes unlimited = m_kp[block]*error + m_integral[block] + derivative;
+    ControlLanes output = clamp(unlimited, m_min[block], m_max[block]);
+    m_integral[block] += m_ki[block]*error + m_kaw[block]*(output - unlimited);
+    m_derivative[block] = derivative;
+    m_previous[block] = measurement;
+    m_output[block] = output;
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Biquad designs (RBJ audio EQ cookbook)
+
+BiquadCoefficients BiquadCoefficients::lowPass(double frequency, double q, double cycleTime){
+  double w = 2.0*M_PI*frequency*cycleTime;
+  double alpha = std::sin(w)/(2.0*q);
+  double c = std::cos(w);
+  return normalize((1.0 - c)/2.0, 1.0 - c, (1.0 - c)/2.0, 1.0 + alpha, -2.0*c, 1.0 - alpha);
+}
+
+BiquadCoefficients BiquadCoefficients::highPass(double frequency, double q, double cycleTime){
+  double w = 2.0*M_PI*frequency*cycleTime;
+  double alpha = std::sin(w)/(2.0*q);
+  double c = std::cos(w);
+  return normalize((1.0 + c)/2.0, -(1.0 + c), (1.0 + c)/2.0, 1.0 + alpha, -2.0*c, 1.0 - alpha);
+}
+
+BiquadCoefficients BiquadCoefficients::notch(double frequency, double q, double cycleTime){
+  double w = 2.0*M_PI*frequency*cycleTime;
+  double alpha = std::sin(w)/(2.0*q);
+  double c = std::cos(w);
+  return normalize(1.0, -2.0*c, 1.0, 1.0 + alpha, -2.0*c, 1.0 - alpha);
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Biquad, float
+
+int BiquadBank::add(const BiquadCoefficients& coefficients){
+  uint32_t index = m_count++;
+  grow<ControlLanes>(m_count, {&m_b0, &m_b1, &m_b2, &m_a1, &m_a2, &m_z1, &m_z2, &m_input, &m_output});
+  uint32_t block = index/CONTROL_LANES;
+  uint32_t lane = index%CONTROL_LANES;
+  m_b0[block][lane] = static_cast<float>(coefficients.b0);
+  m_b1[block][lane] = static_cast<float>(coefficients.b1);
+  m_b2[block][lane] = static_cast<float>(coefficients.b2);
+  m_a1[block][lane] = static_cast<float>(coefficients.a1);
+  m_a2[block][lane] = static_cast<float>(coefficients.a2);
+  return static_cast<int>(index);
+}
+
+void BiquadBank::clear(){
+  m_count = 0;
+  release<ControlLanes>({&m_b0, &m_b1, &m_b2, &m_a1, &m_a2, &m_z1, &m_z2, &m_input, &m_output});
+}
+
+void BiquadBank::reset(){
+  zero<ControlLanes>({&m_z1, &m_z2, &m_output});
+}
+
+void BiquadBank::update(){
+  for(size_t block = 0; block < m_b0.size(); block++){
+    ControlLanes x = m_input[block];
+    ControlLanes y = m_b0[block]*x + m_z1[block];
+    m_z1[block] = m_b1[block]*x - m_a1[block]*y + m_z2[block];
+    m_z2[block] = m_b2[block]*x - m_a2[block]*y;
+    m_output[block] = y;
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Biquad, fixed point
+
+int FixedBiquadBank::add(const BiquadCoefficients& coefficients){
+  int32_t b0, b1, b2, a1, a2;
+  if(!toFixed(coefficients.b0, b0) || !toFixed(coefficients.b1, b1) || !toFixed(coefficients.b2, b2) ||
+     !toFixed(coefficients.a1, a1) || !toFixed(coefficients.a2, a2))
+    return -1;
+  uint32_t index = m_count++;
+  grow<FixedLanes>(m_count, {&m_b0, &m_b1, &m_b2, &m_a1, &m_a2, &m_x1, &m_x2, &m_y1, &m_y2, &m_input});
+  uint32_t block = index/CONTROL_LANES;
+  uint32_t lane = index%CONTROL_LANES;
+  m_b0[block][lane] = b0;
+  m_b1[block][lane] = b1;
+  m_b2[block][lane] = b2;
+  m_a1[block][lane] = a1;
+  m_a2[block][lane] = a2;
+  return static_cast<int>(index);
+}
+
+void FixedBiquadBank::clear(){
+  m_count = 0;
+  release<FixedLanes>({&m_b0, &m_b1, &m_b2, &m_a1, &m_a2, &m_x1, &m_x2, &m_y1, &m_y2, &m_input});
+}
+
+void FixedBiquadBank::reset(){
+  zero<FixedLanes>({&m_x1, &m_x2, &m_y1, &m_y2});
+}
+
+void FixedBiquadBank::update(){
+  const WideLanes round = WideLanes{} + (int64_t(1) << (FRACTION_BITS - 1));
+  const WideLanes lowest = WideLanes{} + INT32_MIN;
+  const WideLanes highest = WideLanes{} + INT32_MAX;
+  for(size_t block = 0; block < m_b0.size(); block++){
+    FixedLanes x = m_input[block];
+    WideLanes sum = __builtin_convertvector(m_b0[block], WideLanes)*__builtin_convertvector(x, WideLanes)
+                  + __builtin_convertvector(m_b1[block], WideLanes)*__builtin_convertvector(m_x1[block], WideLanes)
+                  + __builtin_convertvector(m_b2[block], WideLanes)*__builtin_convertvector(m_x2[block], WideLanes)
+                  - __builtin_convertvector(m_a1[block], WideLanes)*__builtin_convertvector(m_y1[block], WideLanes)
+                  - __builtin_convertvector(m_a2[block], WideLanes)*__builtin_convertvector(m_y2[block], WideLanes);
+    sum = (sum + round) >> FRACTION_BITS;
+    sum = sum < highest ? sum : highest;
+    sum = sum > lowest ? sum : lowest;
+    m_x2[block] = m_x1[block];
+    m_x1[block] = x;
+    m_y2[block] = m_y1[block];
+    m_y1[block] = __builtin_convertvector(sum, FixedLanes);
+  }
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Moving average, float
+
+MovingAverageBank::MovingAverageBank(uint32_t length){
+  setLength(length);
+}
+
+void MovingAverageBank::setLength(uint32_t length){
+  clear();
+  m_length = std::max<uint32_t>(length, 1);
+  m_scale = 1.0f/m_length;
+}
+
+int MovingAverageBank::add(){
+  uint32_t index = m_count++;
+  grow<ControlLanes>(m_count, {&m_sum, &m_compensation, &m_input, &m_output});
+  m_blocks = static_cast<uint32_t>(m_sum.size());
+  m_history.assign(static_cast<size_t>(m_length)*m_blocks, ControlLanes{});
+  reset();
+  return static_cast<int>(index);
+}
+
+void MovingAverageBank::clear(){
+  m_count = 0;
+  m_blocks = 0;
+  m_position = 0;
+  release<ControlLanes>({&m_history, &m_sum, &m_compensation, &m_input, &m_output});
+}
+
+void MovingAverageBank::reset(){
+  zero<ControlLanes>({&m_history, &m_sum, &m_compensation, &m_output});
+  m_position = 0;
+}
+
+void MovingAverageBank::update(){
+  ControlLanes* history = m_history.data() + static_cast<size_t>(m_position)*m_blocks;
+  for(uint32_t block = 0; block < m_blocks; block++){
+    ControlLanes input = m_input[block];
+    // compensated summation of the difference between the new and the dropped sample
+    ControlLanes delta = (input - history[block]) - m_compensation[block];
+    ControlLanes sum = m_sum[block] + delta;
+    m_compensation[block] = (sum - m_sum[block]) - delta;
+    m_sum[block] = sum;
+    history[block] = input;
+    m_output[block] = sum*m_scale;
+  }
+  if(++m_position == m_length)
+    m_position = 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Moving average, fixed point
+
+FixedMovingAverageBank::FixedMovingAverageBank(uint32_t lengthLog2){
+  setLength(lengthLog2);
+}
+
+void FixedMovingAverageBank::setLength(uint32_t lengthLog2){
+  clear();
+  m_shift = std::min<uint32_t>(lengthLog2, 16);
+}
+
+int FixedMovingAverageBank::add(){
+  uint32_t index = m_count++;
+  grow<FixedLanes>(m_count, {&m_input, &m_output});
+  grow<WideLanes>(m_count, {&m_sum});
+  m_blocks = static_cast<uint32_t>(m_sum.size());
+  m_history.assign(static_cast<size_t>(m_blocks) << m_shift, FixedLanes{});
+  reset();
+  return static_cast<int>(index);
+}
+
+void FixedMovingAverageBank::clear(){
+  m_count = 0;
+  m_blocks = 0;
+  m_position = 0;
+  release<FixedLanes>({&m_history, &m_input, &m_output});
+  release<WideLanes>({&m_sum});
+}
+
+void FixedMovingAverageBank::reset(){
+  zero<FixedLanes>({&m_history, &m_output});
+  zero<WideLanes>({&m_sum});
+  m_position = 0;
+}
+
+void FixedMovingAverageBank::update(){
+  FixedLanes* history = m_history.data() + static_cast<size_t>(m_position)*m_blocks;
+  for(uint32_t block = 0; block < m_blocks; block++){
+    FixedLanes input = m_input[block];
+    m_sum[block] += __builtin_convertvector(input, WideLanes) - __builtin_convertvector(history[block], WideLanes);
+    history[block] = input;
+    // arithmetic shift, the result is rounded towards minus infinity
+    m_output[block] = __builtin_convertvector(m_sum[block] >> m_shift, FixedLanes);
+  }
+  m_position = (m_position + 1) & ((1u << m_shift) - 1);
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Velocity observer
+
+int VelocityObserverBank::add(float bandwidth, float cycleTime, float scale){
+  if(bandwidth <= 0.0f || cycleTime <= 0.0f)
+    return -1;
+  uint32_t index = m_count++;
+  grow<ControlLanes>(m_count, {&m_alpha, &m_beta, &m_cycleTime, &m_scale, &m_offset, &m_velocity, &m_output});
+  grow<FixedLanes>(m_count, {&m_last, &m_input});
+
+  // both poles of the error dynamics at exp(-bandwidth*Ts), i.e. critically damped
+  double pole = std::exp(-static_cast<double>(bandwidth)*cycleTime);
+  uint32_t block = index/CONTROL_LANES;
+  uint32_t lane = index%CONTROL_LANES;
+  m_alpha[block][lane] = static_cast<float>(1.0 - pole*pole);
+  m_beta[block][lane] = static_cast<float>((1.0 - pole)*(1.0 - pole)/cycleTime);
+  m_cycleTime[block][lane] = cycleTime;
+  m_scale[block][lane] = scale;
+  m_initialized = false;
+  return static_cast<int>(index);
+}
+
+void VelocityObserverBank::clear(){
+  m_count = 0;
+  m_initialized = false;
+  release<ControlLanes>({&m_alpha, &m_beta, &m_cycleTime, &m_scale, &m_offset, &m_velocity, &m_output});
+  release<FixedLanes>({&m_last, &m_input});
+}
+
+void VelocityObserverBank::reset(){
+  zero<ControlLanes>({&m_offset, &m_velocity, &m_output});
+  m_initialized = false;
+}
+
+void VelocityObserverBank::update(){
+  if(!m_initialized){
+    m_last = m_input;
+    m_initialized = true;
+    return;
+  }
+  typedef uint32_t CountLanes __attribute__((vector_size(16)));
+  for(size_t block = 0; block < m_alpha.size(); block++){
+    // the difference of the counters is taken modulo 2^32, so a wrap of the feedback is harmless
+    CountLanes counts = reinterpret_cast<CountLanes&>(m_input[block]) - reinterpret_cast<CountLanes&>(m_last[block]);
+    ControlLanes delta = __builtin_convertvector(reinterpret_cast<FixedLanes&>(counts), ControlLanes);
+    // prediction relative to the new measurement, the error is its negative
+    ControlLanes predicted = m_offset[block] + m_cycleTime[block]*m_velocity[block] - delta;
+    m_offset[block] = predicted - m_alpha[block]*predicted;
+    m_velocity[block] -= m_beta[block]*predicted;
+    m_last[block] = m_input[block];
+    m_output[block] = m_velocity[block]*m_scale[block];
+  }
+}
+}
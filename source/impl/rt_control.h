@@ -0,0 +1,208 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace Example{
+  // Control blocks are stored structure-of-arrays in vector lanes of four instances (SSE on x64,
+  // NEON on aarch64), so update() runs a whole bank in one loop. Instances and coefficients are set up
+  // in non-RT code, unused lanes of the last block run with zero coefficients.
+  typedef float ControlLanes __attribute__((vector_size(16)));
+  typedef int32_t FixedLanes __attribute__((vector_size(16)));
+  typedef int64_t WideLanes __attribute__((vector_size(32)));
+  constexpr uint32_t CONTROL_LANES = 4;
+
+  struct PidParameters
+  {
+    float kp = 0.0f;
+    float ki = 0.0f;              // integral gain, 1/s
+    float kd = 0.0f;              // derivative gain, s
+    float derivativeFilter = 0.0f; // time constant of the derivative filter, s
+    float min = -1.0f;            // output limits
+    float max = 1.0f;
+    float trackingTime = 0.0f;    // anti-windup back-calculation time constant, s; 0 selects sqrt(kd/ki), kp/ki without kd
+  };
+
+  // PID with derivative on the measurement and back-calculation anti-windup
+  class PidBank
+  {
+    public:
+      // Configuration, non-RT. Returns the instance index.
+      int add(const PidParameters& parameters, float cycleTime);
+      void clear();
+      uint32_t size() const { return m_count; }
+
+      // RT side
+      void setInput(uint32_t index, float setpoint, float measurement){
+        m_setpoint[index/CONTROL_LANES][index%CONTROL_LANES] = setpoint;
+        m_measurement[index/CONTROL_LANES][index%CONTROL_LANES] = measurement;
+      }
+      void update();
+      float output(uint32_t index) const { return m_output[index/CONTROL_LANES][index%CONTROL_LANES]; }
+      void reset();
+
+    private:
+      uint32_t m_count = 0;
+      // coefficients
+      std::vector<ControlLanes> m_kp;
+      std::vector<ControlLanes> m_ki;     // ki*Ts
+      std::vector<ControlLanes> m_decay;  // Tf/(Tf+Ts)
+      std::vector<ControlLanes> m_kd;     // kd/(Tf+Ts)
+      std::vector<ControlLanes> m_kaw;    // Ts/Tt
+      std::vector<ControlLanes> m_min;
+      std::vector<ControlLanes> m_max;
+      // state and signals
+      std::vector<ControlLanes> m_integral;
+      std::vector<ControlLanes> m_derivative;
+      std::vector<ControlLanes> m_previous;
+      std::vector<ControlLanes> m_setpoint;
+      std::vector<ControlLanes> m_measurement;
+      std::vector<ControlLanes> m_output;
+  };
+
+  // Normalized coefficients of H(z) = (b0 + b1 z^-1 + b2 z^-2)/(1 + a1 z^-1 + a2 z^-2)
+  struct BiquadCoefficients
+  {
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+
+    // Bilinear designs with prewarped frequencies in Hz, cycle time in s
+    static BiquadCoefficients lowPass(double frequency, double q, double cycleTime);
+    static BiquadCoefficients highPass(double frequency, double q, double cycleTime);
+    static BiquadCoefficients notch(double frequency, double q, double cycleTime);
+  };
+
+  // Second order sections in transposed direct form II
+  class BiquadBank
+  {
+    public:
+      int add(const BiquadCoefficients& coefficients);
+      void clear();
+      uint32_t size() const { return m_count; }
+
+      void setInput(uint32_t index, float value) { m_input[index/CONTROL_LANES][index%CONTROL_LANES] = value; }
+      void update();
+      float output(uint32_t index) const { return m_output[index/CONTROL_LANES][index%CONTROL_LANES]; }
+      void reset();
+
+    private:
+      uint32_t m_count = 0;
+      std::vector<ControlLanes> m_b0, m_b1, m_b2, m_a1, m_a2;
+      std::vector<ControlLanes> m_z1, m_z2;
+      std::vector<ControlLanes> m_input;
+      std::vector<ControlLanes> m_output;
+  };
+
+  // Second order sections on int32 samples in direct form I, coefficients in Q2.29 (|c| < 4),
+  // 64 bit accumulation with rounding and saturation. Bitwise reproducible on every target.
+  class FixedBiquadBank
+  {
+    public:
+      static constexpr int FRACTION_BITS = 29;
+
+      // Returns -1 if a coefficient does not fit the format
+      int add(const BiquadCoefficients& coefficients);
+      void clear();
+      uint32_t size() const { return m_count; }
+
+      void setInput(uint32_t index, int32_t value) { m_input[index/CONTROL_LANES][index%CONTROL_LANES] = value; }
+      void update();
+      int32_t output(uint32_t index) const { return m_y1[index/CONTROL_LANES][index%CONTROL_LANES]; }
+      void reset();
+
+    private:
+      uint32_t m_count = 0;
+      std::vector<FixedLanes> m_b0, m_b1, m_b2, m_a1, m_a2;
+      std::vector<FixedLanes> m_x1, m_x2, m_y1, m_y2;
+      std::vector<FixedLanes> m_input;
+  };
+
+  // Moving average over the same number of ticks for all instances of the bank.
+  // The running sum is compensated (Kahan) so it does not drift over long runs.
+  class MovingAverageBank
+  {
+    public:
+      explicit MovingAverageBank(uint32_t length = 16);
+      // Changes the window length and removes all instances
+      void setLength(uint32_t length);
+      int add();
+      void clear();
+      uint32_t size() const { return m_count; }
+
+      void setInput(uint32_t index, float value) { m_input[index/CONTROL_LANES][index%CONTROL_LANES] = value; }
+      void update();
+      float output(uint32_t index) const { return m_output[index/CONTROL_LANES][index%CONTROL_LANES]; }
+      void reset();
+
+    private:
+      uint32_t m_count = 0;
+      uint32_t m_blocks = 0;
+      uint32_t m_length;
+      uint32_t m_position = 0;
+      float m_scale;
+      std::vector<ControlLanes> m_history; // m_length rows of m_blocks blocks
+      std::vector<ControlLanes> m_sum;
+      std::vector<ControlLanes> m_compensation;
+      std::vector<ControlLanes> m_input;
+      std::vector<ControlLanes> m_output;
+  };
+
+  // Moving average on int32 samples with an exact 64 bit running sum, the length is a power of two
+  class FixedMovingAverageBank
+  {
+    public:
+      explicit FixedMovingAverageBank(uint32_t lengthLog2 = 4);
+      void setLength(uint32_t lengthLog2);
+      int add();
+      void clear();
+      uint32_t size() const { return m_count; }
+
+      void setInput(uint32_t index, int32_t value) { m_input[index/CONTROL_LANES][index%CONTROL_LANES] = value; }
+      void update();
+      int32_t output(uint32_t index) const { return m_output[index/CONTROL_LANES][index%CONTROL_LANES]; }
+      void reset();
+
+    private:
+      uint32_t m_count = 0;
+      uint32_t m_blocks = 0;
+      uint32_t m_shift;
+      uint32_t m_position = 0;
+      std::vector<FixedLanes> m_history;
+      std::vector<WideLanes> m_sum;
+      std::vector<FixedLanes> m_input;
+      std::vector<FixedLanes> m_output;
+  };
+
+  // Tracking observer (alpha-beta filter) for the velocity of an int32 position feedback, e.g. encoder counts.
+  // The estimate is kept relative to the last measurement, so neither the float precision nor
+  // a wrap of the counter limits the range.
+  class VelocityObserverBank
+  {
+    public:
+      // bandwidth in rad/s, scale converts counts/s to the output unit. Returns the instance index.
+      int add(float bandwidth, float cycleTime, float scale = 1.0f);
+      void clear();
+      uint32_t size() const { return m_count; }
+
+      // The first sample after add() or reset() only initializes the instance
+      void setInput(uint32_t index, int32_t position) { m_input[index/CONTROL_LANES][index%CONTROL_LANES] = position; }
+      void update();
+      float velocity(uint32_t index) const { return m_output[index/CONTROL_LANES][index%CONTROL_LANES]; }
+      void reset();
+
+    private:
+      uint32_t m_count = 0;
+      bool m_initialized = false;
+      std::vector<ControlLanes> m_alpha;
+      std::vector<ControlLanes> m_beta;  // beta/Ts
+      std::vector<ControlLanes> m_cycleTime;
+      std::vector<ControlLanes> m_scale;
+      std::vector<ControlLanes> m_offset;   // estimated position - last measurement
+      std::vector<ControlLanes> m_velocity; // counts/s
+      std::vector<FixedLanes> m_last;
+      std::vector<FixedLanes> m_input;
+      std::vector<ControlLanes> m_output;
+  };
+}
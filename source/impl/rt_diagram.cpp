@@ -0,0 +1,440 @@
+#include "rt_diagram.h"
+#include "rt_control.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <sstream>
+
+namespace Example{
+namespace {
+  struct Node
+  {
+    int line;
+    std::string name;
+    std::string block;
+    std::vector<std::string> operands;
+    std::map<std::string, double> parameters;
+    std::vector<int> sources;     // node index per operand, -1 for a constant
+    std::vector<double> constants;
+  };
+
+  bool parseNumber(const std::string& token, double& value){
+    if(token.empty())
+      return false;
+    char* end;
+    value = std::strtod(token.c_str(), &end);
+    return *end == 0;
+  }
+
+  double parameter(const Node& node, const char* name, double fallback){
+    auto value = node.parameters.find(name);
+    return value == node.parameters.end() ? fallback : value->second;
+  }
+
+  std::string at(const Node& node){
+    return "line " + std::to_string(node.line) + " (" + node.name + "): ";
+  }
+
+  template<typename T>
+  inline double loadValue(const uint8_t* data){
+    T raw;
+    std::memcpy(&raw, data, sizeof(T));
+    return static_cast<double>(raw);
+  }
+
+  // saturating, integers rounded to nearest even
+  template<typename T>
+  inline void storeValue(uint8_t* data, double value){
+    const double lowest = static_cast<double>(std::numeric_limits<T>::lowest());
+    const double highest = static_cast<double>(std::numeric_limits<T>::max());
+    T raw;
+    if(std::numeric_limits<T>::is_integer){
+      value = value < highest ? value : highest;
+      value = value > lowest ? value : lowest;
+      raw = static_cast<T>(std::nearbyint(value));
+    }
+    else{
+      raw = static_cast<T>(value);
+    }
+    std::memcpy(data, &raw, sizeof(T));
+  }
+
+  inline double truth(bool value){
+    return value ? 1.0 : 0.0;
+  }
+}
+
+bool BlockDiagram::load(const std::string& path, ProcessImage& image, std::string& error){
+  std::ifstream file(path);
+  if(!file){
+    clear();
+    error = "cannot open " + path;
+    return false;
+  }
+  return compile(file, image, error);
+}
+
+void BlockDiagram::clear(){
+  m_program.clear();
+  m_arena.clear();
+  m_names.clear();
+  m_blocks = 0;
+}
+
+int BlockDiagram::slot(std::string_view name) const{
+  auto entry = m_names.find(name);
+  return entry != m_names.end() ? static_cast<int>(entry->second) : -1;
+}
+
+bool BlockDiagram::compile(std::istream& source, ProcessImage& image, std::string& error){
+  struct Spec
+  {
+    const char* name;
+    Op op;
+    uint32_t operands;
+    std::vector<std::string> parameters;
+  };
+  static const std::vector<Spec> SPECS = {
+    {"add", Op::Add, 2, {}}, {"sub", Op::Sub, 2, {}}, {"mul", Op::Mul, 2, {}}, {"div", Op::Div, 2, {}},
+    {"neg", Op::Neg, 1, {}}, {"abs", Op::Abs, 1, {}}, {"min", Op::Min, 2, {}}, {"max", Op::Max, 2, {}},
+    {"limit", Op::Limit, 3, {}},
+    {"gt", Op::Greater, 2, {}}, {"ge", Op::GreaterEqual, 2, {}}, {"lt", Op::Less, 2, {}}, {"le", Op::LessEqual, 2, {}},
+    {"eq", Op::Equal, 2, {}}, {"ne", Op::NotEqual, 2, {}}, {"and", Op::And, 2, {}}, {"or", Op::Or, 2, {}},
+    {"not", Op::Not, 1, {}}, {"select", Op::Select, 3, {}}, {"bit", Op::Bit, 1, {"n"}},
+    {"delay", Op::Delay, 1, {"init"}}, {"rise", Op::Rise, 1, {}}, {"sr", Op::SetReset, 2, {}},
+    {"ton", Op::OnDelay, 1, {"time"}}, {"integrate", Op::Integrate, 1, {"gain", "min", "max"}},
+    {"pid", Op::Pid, 2, {"kp", "ki", "kd", "tf", "min", "max", "tt"}},
+    {"lowpass", Op::Biquad, 1, {"freq", "q"}}, {"highpass", Op::Biquad, 1, {"freq", "q"}}, {"notch", Op::Biquad, 1, {"freq", "q"}},
+    {"input", Op::InputBool, 0, {}}, {"output", Op::OutputBool, 1, {}},
+  };
+  static const std::vector<std::string> TYPES = {"bool", "int8", "uint8", "int16", "uint16", "int32", "uint32", "float32", "float64"};
+  static const uint32_t TYPE_BITS[] = {1, 8, 8, 16, 16, 32, 32, 32, 64};
+
+  clear();
+  auto fail = [&](const std::string& message){
+    clear();
+    error = message;
+    return false;
+  };
+
+  // parse
+  std::vector<Node> nodes;
+  std::map<std::string, int> names;
+  double cycleTime = 0.001;
+  std::string text;
+  for(int line = 1; std::getline(source, text); line++){
+    text = text.substr(0, text.find('#'));
+    std::istringstream stream(text);
+    std::vector<std::string> tokens;
+    for(std::string token; stream >> token;)
+      tokens.push_back(token);
+    if(tokens.empty())
+      continue;
+    if(tokens[0] == "cycle"){
+      if(tokens.size() != 2 || !parseNumber(tokens[1], cycleTime) || cycleTime <= 0.0)
+        return fail("line " + std::to_string(line) + ": expected 'cycle <seconds>'");
+      continue;
+    }
+    double number;
+    if(tokens.size() < 3 || tokens[1] != "=" || parseNumber(tokens[0], number))
+      return fail("line " + std::to_string(line) + ": expected '<name> = <block> <operands>'");
+    Node node;
+    node.line = line;
+    node.name = tokens[0];
+    node.block = tokens[2];
+    for(size_t index = 3; index < tokens.size(); index++){
+      auto separator = tokens[index].find('=');
+      if(separator == std::string::npos){
+        node.operands.push_back(tokens[index]);
+        continue;
+      }
+      if(!parseNumber(tokens[index].substr(separator + 1), number))
+        return fail(at(node) + "invalid value of " + tokens[index]);
+      node.parameters[tokens[index].substr(0, separator)] = number;
+    }
+    if(!names.emplace(node.name, static_cast<int>(nodes.size())).second)
+      return fail(at(node) + "name is used twice");
+    nodes.push_back(node);
+  }
+
+  // check the blocks and resolve the operands
+  std::vector<const Spec*> specs;
+  std::vector<std::vector<int>> consumers(nodes.size());
+  std::vector<int> pending(nodes.size(), 0);
+  for(size_t index = 0; index < nodes.size(); index++){
+    Node& node = nodes[index];
+    auto spec = std::find_if(SPECS.begin(), SPECS.end(), [&](const Spec& spec){ return node.block == spec.name; });
+    if(spec == SPECS.end())
+      return fail(at(node) + "unknown block " + node.block);
+    specs.push_back(&*spec);
+    // input/output carry the variable and its type in front of the operands
+    size_t first = 0;
+    if(spec->op == Op::InputBool || spec->op == Op::OutputBool)
+      first = 2;
+    if(node.operands.size() != first + spec->operands)
+      return fail(at(node) + node.block + " expects " + std::to_string(spec->operands) + " operands");
+    for(auto& parameter : node.parameters){
+      if(std::find(spec->parameters.begin(), spec->parameters.end(), parameter.first) == spec->parameters.end())
+        return fail(at(node) + node.block + " has no parameter " + parameter.first);
+    }
+    for(size_t operand = first; operand < node.operands.size(); operand++){
+      auto other = names.find(node.operands[operand]);
+      double constant = 0.0;
+      if(other != names.end()){
+        node.sources.push_back(other->second);
+        node.constants.push_back(0.0);
+        // a delay outputs the value of the previous tick, its operand is no dependency
+        if(spec->op != Op::Delay){
+          consumers[other->second].push_back(static_cast<int>(index));
+          pending[index]++;
+        }
+      }
+      else if(parseNumber(node.operands[operand], constant)){
+        node.sources.push_back(-1);
+        node.constants.push_back(constant);
+      }
+      else{
+        return fail(at(node) + "unknown operand " + node.operands[operand]);
+      }
+    }
+  }
+
+  // topological order, ties in file order
+  std::vector<int> order;
+  std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+  for(size_t index = 0; index < nodes.size(); index++){
+    if(pending[index] == 0)
+      ready.push(static_cast<int>(index));
+  }
+  while(!ready.empty()){
+    int index = ready.top();
+    ready.pop();
+    order.push_back(index);
+    for(int consumer : consumers[index]){
+      if(--pending[consumer] == 0)
+        ready.push(consumer);
+    }
+  }
+  if(order.size() != nodes.size()){
+    for(size_t index = 0; index < nodes.size(); index++){
+      if(pending[index] != 0)
+        return fail(at(nodes[index]) + "loop without a delay block");
+    }
+  }
+
+  // arena: block outputs in execution order, then constants, then block state
+  std::vector<uint32_t> slots(nodes.size());
+  for(size_t position = 0; position < order.size(); position++)
+    slots[order[position]] = static_cast<uint32_t>(position);
+  std::vector<double> arena(nodes.size(), 0.0);
+  std::map<double, uint32_t> constants;
+  auto operand = [&](const Node& node, size_t index) -> uint32_t {
+    if(node.sources[index] >= 0)
+      return slots[node.sources[index]];
+    auto constant = constants.find(node.constants[index]);
+    if(constant != constants.end())
+      return constant->second;
+    arena.push_back(node.constants[index]);
+    return constants[node.constants[index]] = static_cast<uint32_t>(arena.size() - 1);
+  };
+  auto state = [&](std::initializer_list<double> values) -> uint32_t {
+    uint32_t first = static_cast<uint32_t>(arena.size());
+    arena.insert(arena.end(), values);
+    return first;
+  };
+
+  std::vector<Instruction> program;
+  std::vector<Instruction> delays;
+  for(int index : order){
+    const Node& node = nodes[index];
+    const Spec& spec = *specs[index];
+    Instruction instruction{spec.op, slots[index], 0, 0, 0};
+    size_t first = 0;
+
+    if(spec.op == Op::InputBool || spec.op == Op::OutputBool){
+      auto type = std::find(TYPES.begin(), TYPES.end(), node.operands[1]);
+      if(type == TYPES.end())
+        return fail(at(node) + "unknown type " + node.operands[1]);
+      uint32_t typeIndex = static_cast<uint32_t>(type - TYPES.begin());
+      const ImageVariable* variable = spec.op == Op::InputBool ? image.input(node.operands[0]) : image.output(node.operands[0]);
+      if(!variable)
+        return fail(at(node) + node.operands[0] + " does not exist in the " + node.block + " image");
+      if(typeIndex != 0 && (variable->bitOffset % 8 != 0 || (variable->bitSize != 0 && variable->bitSize != TYPE_BITS[typeIndex])))
+        return fail(at(node) + node.operands[0] + " has " + std::to_string(variable->bitSize) + " bits, " + *type + " needs " + std::to_string(TYPE_BITS[typeIndex]));
+      instruction.op = static_cast<Op>(static_cast<uint32_t>(spec.op) + typeIndex);
+      instruction.a = variable->byteOffset();
+      instruction.b = variable->bitOffset % 8;
+      if(spec.op == Op::OutputBool)
+        instruction.c = operand(node, 0);
+      program.push_back(instruction);
+      continue;
+    }
+
+    if(node.sources.size() > first)
+      instruction.a = operand(node, first);
+    if(node.sources.size() > first + 1)
+      instruction.b = operand(node, first + 1);
+    if(node.sources.size() > first + 2)
+      instruction.c = operand(node, first + 2);
+
+    switch(spec.op){
+    case Op::Bit:
+      instruction.b = static_cast<uint32_t>(std::clamp(parameter(node, "n", 0.0), 0.0, 63.0));
+      break;
+    case Op::Delay:
+      arena[instruction.out] = parameter(node, "init", 0.0);
+      delays.push_back(instruction);
+      continue;
+    case Op::Rise:
+      instruction.c = state({0.0});
+      break;
+    case Op::OnDelay:
+      instruction.c = state({0.0, std::round(parameter(node, "time", 0.0)/cycleTime)});
+      break;
+    case Op::Integrate:
+      instruction.c = state({parameter(node, "gain", 1.0)*cycleTime, parameter(node, "min", -HUGE_VAL), parameter(node, "max", HUGE_VAL)});
+      break;
+    case Op::Pid:{
+      double kp = parameter(node, "kp", 0.0);
+      double ki = parameter(node, "ki", 0.0);
+      double kd = parameter(node, "kd", 0.0);
+      double filter = std::max(parameter(node, "tf", 0.0), 0.0);
+      double tracking = parameter(node, "tt", 0.0);
+      if(tracking <= 0.0 && ki > 0.0)
+        tracking = kd > 0.0 ? std::sqrt(kd/ki) : kp/ki;
+      double kaw = tracking > 0.0 ? std::min(cycleTime/tracking, 1.0) : 0.0;
+      // integral, derivative, previous measurement, coefficients as in PidBank
+      instruction.c = state({0.0, 0.0, 0.0, kp, ki*cycleTime, filter/(filter + cycleTime), kd/(filter + cycleTime), kaw,
+                             parameter(node, "min", -HUGE_VAL), parameter(node, "max", HUGE_VAL)});
+      break;
+    }
+    case Op::Biquad:{
+      double frequency = parameter(node, "freq", 0.0);
+      double q = parameter(node, "q", M_SQRT1_2);
+      if(frequency <= 0.0 || frequency >= 0.5/cycleTime || q <= 0.0)
+        return fail(at(node) + "freq has to be between 0 and half the cycle frequency");
+      BiquadCoefficients coefficients = node.block == "lowpass" ? BiquadCoefficients::lowPass(frequency, q, cycleTime)
+                                      : node.block == "highpass" ? BiquadCoefficients::highPass(frequency, q, cycleTime)
+                                      : BiquadCoefficients::notch(frequency, q, cycleTime);
+      instruction.c = state({coefficients.b0, coefficients.b1, coefficients.b2, coefficients.a1, coefficients.a2, 0.0, 0.0});
+      break;
+    }
+    default:
+      break;
+    }
+    program.push_back(instruction);
+  }
+  // delays take their new value after everything else has run
+  program.insert(program.end(), delays.begin(), delays.end());
+
+  m_program = std::move(program);
+  m_arena = std::move(arena);
+  m_blocks = nodes.size();
+  m_names.reserve(nodes.size());
+  for(size_t index = 0; index < nodes.size(); index++)
+    m_names.insert(nodes[index].name, slots[index]);
+  m_names.sort();
+  error.clear();
+  return true;
+}
+
+void BlockDiagram::execute(const uint8_t* inData, uint8_t* outData){
+  double* s = m_arena.data();
+  for(const Instruction& i : m_program){
+    switch(i.op){
+    case Op::InputBool:     s[i.out] = truth(inData[i.a] & (1u << i.b)); break;
+    case Op::InputInt8:     s[i.out] = loadValue<int8_t>(inData + i.a); break;
+    case Op::InputUInt8:    s[i.out] = loadValue<uint8_t>(inData + i.a); break;
+    case Op::InputInt16:    s[i.out] = loadValue<int16_t>(inData + i.a); break;
+    case Op::InputUInt16:   s[i.out] = loadValue<uint16_t>(inData + i.a); break;
+    case Op::InputInt32:    s[i.out] = loadValue<int32_t>(inData + i.a); break;
+    case Op::InputUInt32:   s[i.out] = loadValue<uint32_t>(inData + i.a); break;
+    case Op::InputFloat32:  s[i.out] = loadValue<float>(inData + i.a); break;
+    case Op::InputFloat64:  s[i.out] = loadValue<double>(inData + i.a); break;
+    case Op::OutputBool:
+      s[i.out] = s[i.c];
+      outData[i.a] = static_cast<uint8_t>((outData[i.a] & ~(1u << i.b)) | ((s[i.c] != 0.0 ? 1u : 0u) << i.b));
+      break;
+    case Op::OutputInt8:    s[i.out] = s[i.c]; storeValue<int8_t>(outData + i.a, s[i.c]); break;
+    case Op::OutputUInt8:   s[i.out] = s[i.c]; storeValue<uint8_t>(outData + i.a, s[i.c]); break;
+    case Op::OutputInt16:   s[i.out] = s[i.c]; storeValue<int16_t>(outData + i.a, s[i.c]); break;
+    case Op::OutputUInt16:  s[i.out] = s[i.c]; storeValue<uint16_t>(outData + i.a, s[i.c]); break;
+    case Op::OutputInt32:   s[i.out] = s[i.c]; storeValue<int32_t>(outData + i.a, s[i.c]); break;
+    case Op::OutputUInt32:  s[i.out] = s[i.c]; storeValue<uint32_t>(outData + i.a, s[i.c]); break;
+    case Op::OutputFloat32: s[i.out] = s[i.c]; storeValue<float>(outData + i.a, s[i.c]); break;
+    case Op::OutputFloat64: s[i.out] = s[i.c]; storeValue<double>(outData + i.a, s[i.c]); break;
+    case Op::Add:           s[i.out] = s[i.a] + s[i.b]; break;
+    case Op::Sub:           s[i.out] = s[i.a] - s[i.b]; break;
+    case Op::Mul:           s[i.out] = s[i.a]*s[i.b]; break;
+    case Op::Div:           s[i.out] = s[i.b] != 0.0 ? s[i.a]/s[i.b] : 0.0; break;
+    case Op::Neg:           s[i.out] = -s[i.a]; break;
+    case Op::Abs:           s[i.out] = std::fabs(s[i.a]); break;
+    case Op::Min:           s[i.out] = s[i.a] < s[i.b] ? s[i.a] : s[i.b]; break;
+    case Op::Max:           s[i.out] = s[i.a] > s[i.b] ? s[i.a] : s[i.b]; break;
+    case Op::Limit:{
+      double value = s[i.a] < s[i.c] ? s[i.a] : s[i.c];
+      s[i.out] = value > s[i.b] ? value : s[i.b];
+      break;
+    }
+    case Op::Greater:       s[i.out] = truth(s[i.a] > s[i.b]); break;
+    case Op::GreaterEqual:  s[i.out] = truth(s[i.a] >= s[i.b]); break;
+    case Op::Less:          s[i.out] = truth(s[i.a] < s[i.b]); break;
+    case Op::LessEqual:     s[i.out] = truth(s[i.a] <= s[i.b]); break;
+    case Op::Equal:         s[i.out] = truth(s[i.a] == s[i.b]); break;
+    case Op::NotEqual:      s[i.out] = truth(s[i.a] != s[i.b]); break;
+    case Op::And:           s[i.out] = truth(s[i.a] != 0.0 && s[i.b] != 0.0); break;
+    case Op::Or:            s[i.out] = truth(s[i.a] != 0.0 || s[i.b] != 0.0); break;
+    case Op::Not:           s[i.out] = truth(s[i.a] == 0.0); break;
+    case Op::Select:        s[i.out] = s[i.a] != 0.0 ? s[i.b] : s[i.c]; break;
+    case Op::Bit:           s[i.out] = truth((static_cast<int64_t>(s[i.a]) >> i.b) & 1); break;
+    case Op::Delay:         s[i.out] = s[i.a]; break;
+    case Op::Rise:
+      s[i.out] = truth(s[i.a] != 0.0 && s[i.c] == 0.0);
+      s[i.c] = s[i.a] != 0.0 ? 1.0 : 0.0;
+      break;
+    case Op::SetReset:      s[i.out] = s[i.b] != 0.0 ? 0.0 : s[i.a] != 0.0 ? 1.0 : s[i.out]; break;
+    case Op::OnDelay:{
+      double* count = s + i.c;
+      count[0] = s[i.a] != 0.0 ? std::min(count[0] + 1.0, count[1]) : 0.0;
+      s[i.out] = truth(s[i.a] != 0.0 && count[0] >= count[1]);
+      break;
+    }
+    case Op::Integrate:{
+      const double* k = s + i.c;
+      double value = s[i.out] + k[0]*s[i.a];
+      value = value < k[2] ? value : k[2];
+      s[i.out] = value > k[1] ? value : k[1];
+      break;
+    }
+    case Op::Pid:{
+      double* k = s + i.c;
+      double measurement = s[i.b];
+      double error = s[i.a] - measurement;
+      double derivative = k[5]*k[1] + k[6]*(k[2] - measurement);
+      double unlimited = k[3]*error + k[0] + derivative;
+      double output = unlimited < k[9] ? unlimited : k[9];
+      output = output > k[8] ? output : k[8];
+      k[0] += k[4]*error + k[7]*(output - unlimited);
+      k[1] = derivative;
+      k[2] = measurement;
+      s[i.out] = output;
+      break;
+    }
+    case Op::Biquad:{
+      double* k = s + i.c;
+      double x = s[i.a];
+      double y = k[0]*x + k[5];
+      k[5] = k[1]*x - k[3]*y + k[6];
+      k[6] = k[2]*x - k[4]*y;
+      s[i.out] = y;
+      break;
+    }
+    }
+  }
+}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "rt_containers.h"
+#include "rt_process_image.h"
+
+namespace Example{
+  // User logic described as a dataflow graph of blocks, read from a text file:
+  //
+  //   # comment
+  //   cycle 0.001                                          cycle time in s for the time based blocks
+  //   <name> = input  <variable> <type>                     type: bool int8 uint8 int16 uint16 int32 uint32 float32 float64
+  //   <name> = output <variable> <type> <operand>
+  //   <name> = <block> <operand>... [parameter=value]...
+  //
+  // Operands are names of other blocks or numeric constants. The graph is sorted topologically and
+  // compiled into a flat list of instructions on slots of one contiguous arena; loops have to be broken
+  // with a delay block. The tick runs the list in a single switch loop, there is no lookup and
+  // no virtual call per block.
+  class BlockDiagram
+  {
+    public:
+      // Non-RT. Binds the used variables in the image, call before ProcessImage::finalize().
+      // On failure the diagram is empty and error names the line.
+      bool compile(std::istream& source, ProcessImage& image, std::string& error);
+      bool load(const std::string& path, ProcessImage& image, std::string& error);
+      void clear();
+      bool empty() const { return m_program.empty(); }
+      size_t blockCount() const { return m_blocks; }
+      size_t instructionCount() const { return m_program.size(); }
+      // Current output of a block, -1 if the name does not exist
+      int slot(std::string_view name) const;
+      double value(uint32_t slot) const { return m_arena[slot]; }
+
+      // RT side, once per tick between reading the inputs and writing the outputs
+      void execute(const uint8_t* inData, uint8_t* outData);
+
+    private:
+      enum class Op : uint32_t
+      {
+        InputBool, InputInt8, InputUInt8, InputInt16, InputUInt16, InputInt32, InputUInt32, InputFloat32, InputFloat64,
+        OutputBool, OutputInt8, OutputUInt8, OutputInt16, OutputUInt16, OutputInt32, OutputUInt32, OutputFloat32, OutputFloat64,
+        Add, Sub, Mul, Div, Neg, Abs, Min, Max, Limit,
+        Greater, GreaterEqual, Less, LessEqual, Equal, NotEqual, And, Or, Not, Select, Bit,
+        Delay, Rise, SetReset, OnDelay, Integrate, Pid, Biquad
+      };
+      // 20 bytes; operands and state are slot indices, for inputs/outputs a is the byte offset and b the bit
+      struct Instruction
+      {
+        Op op;
+        uint32_t out;
+        uint32_t a;
+        uint32_t b;
+        uint32_t c;
+      };
+
+      std::vector<Instruction> m_program;
+      std::vector<double> m_arena;
+      FlatMap<uint32_t> m_names;
+      size_t m_blocks = 0;
+  };
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace Example{
+  // Grace periods between the tick and the non-RT code that tears down what the tick uses, e.g. the bound
+  // memories when the Data Layer or the scheduler goes away. The tick counts its begin and its end, an odd
+  // count means a tick is running; it never waits. Teardown first withdraws the state, e.g. by clearing a
+  // flag the tick checks after enter(), then synchronize() waits until the tick that may still use it has
+  // ended. Ticks of one callable do not overlap, so there is a single reader.
+  class TickEpoch
+  {
+    public:
+      // RT side
+      void enter(){
+        m_count.store(++m_local, std::memory_order_seq_cst);
+      }
+      void exit(){
+        m_count.store(++m_local, std::memory_order_release);
+      }
+
+      // Non-RT, after the state was withdrawn with a seq_cst store
+      void synchronize() const{
+        uint64_t observed = m_count.load(std::memory_order_seq_cst);
+        if(observed % 2 == 0)
+          return;
+        while(m_count.load(std::memory_order_acquire) == observed)
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+
+      // Exits on every path out of the tick
+      class Guard
+      {
+        public:
+          explicit Guard(TickEpoch& epoch):m_epoch(epoch) { m_epoch.enter(); }
+          ~Guard() { m_epoch.exit(); }
+          Guard(const Guard&) = delete;
+          Guard& operator=(const Guard&) = delete;
+
+        private:
+          TickEpoch& m_epoch;
+      };
+
+    private:
+      std::atomic<uint64_t> m_count{0};
+      uint64_t m_local = 0; // RT
+  };
+}
@@ -0,0 +1,163 @@
+#include "rt_export.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Example{
+namespace {
+  constexpr size_t CACHE_LINE = 64;
+
+  size_t alignUp(size_t size){
+    return (size + CACHE_LINE - 1)/CACHE_LINE*CACHE_LINE;
+  }
+
+  void copyName(char (&target)[EXPORT_NAME_SIZE], std::string_view name){
+    size_t length = std::min<size_t>(name.size(), EXPORT_NAME_SIZE - 1);
+    std::memcpy(target, name.data(), length);
+    std::memset(target + length, 0, EXPORT_NAME_SIZE - length);
+  }
+}
+
+ImageExporter::~ImageExporter(){
+  close();
+}
+
+bool ImageExporter::addValue(const std::string& name, const SignalRef& signal){
+  if(m_header || name.size() >= EXPORT_NAME_SIZE)
+    return false;
+  m_names.push_back(name);
+  m_signals.push_back(signal);
+  return true;
+}
+
+bool ImageExporter::open(const std::string& name, const ProcessImage& image){
+  unmap();
+  uint32_t variableCount = image.inputMap().size() + image.outputMap().size();
+  size_t variablesOffset = alignUp(sizeof(ExportHeader));
+  size_t valuesOffset = alignUp(variablesOffset + variableCount*sizeof(ExportVariable));
+  size_t slotsOffset = alignUp(valuesOffset + m_names.size()*sizeof(ExportValue));
+  size_t slotValuesOffset = (sizeof(ExportSlot) + image.inputSize() + image.outputSize() + sizeof(double) - 1)/sizeof(double)*sizeof(double);
+  size_t slotSize = alignUp(slotValuesOffset + m_names.size()*sizeof(double));
+  size_t size = slotsOffset + EXPORT_SLOTS*slotSize;
+
+  // a segment left behind by a previous run may still be mapped by readers, they see it closed and reopen
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if(fd < 0){
+    LOG_ERROR("Image export %s not created: %s", name.c_str(), strerror(errno));
+    return false;
+  }
+  void* memory = MAP_FAILED;
+  if(ftruncate(fd, size) == 0)
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int failure = errno;
+  ::close(fd);
+  if(memory == MAP_FAILED){
+    LOG_ERROR("Image export %s not mapped: %s", name.c_str(), strerror(failure));
+    shm_unlink(name.c_str());
+    return false;
+  }
+  // touches every page, the tick does not take page faults on the segment
+  std::memset(memory, 0, size);
+
+  auto base = static_cast<uint8_t*>(memory);
+  auto header = new (base) ExportHeader();
+  header->layoutVersion = EXPORT_LAYOUT_VERSION;
+  header->slotCount = EXPORT_SLOTS;
+  header->slotSize = slotSize;
+  header->inputSize = image.inputSize();
+  header->outputSize = image.outputSize();
+  header->variableCount = variableCount;
+  header->valueCount = m_names.size();
+  header->slotValuesOffset = slotValuesOffset;
+  header->variablesOffset = variablesOffset;
+  header->valuesOffset = valuesOffset;
+  header->slotsOffset = slotsOffset;
+
+  auto variable = reinterpret_cast<ExportVariable*>(base + variablesOffset);
+  for(auto& entry : image.inputMap()){
+    copyName(variable->name, entry.first);
+    variable->bitOffset = entry.second.bitOffset;
+    variable->bitSize = entry.second.bitSize;
+    variable->output = 0;
+    variable++;
+  }
+  for(auto& entry : image.outputMap()){
+    copyName(variable->name, entry.first);
+    variable->bitOffset = entry.second.bitOffset;
+    variable->bitSize = entry.second.bitSize;
+    variable->output = 1;
+    variable++;
+  }
+  auto value = reinterpret_cast<ExportValue*>(base + valuesOffset);
+  for(auto& valueName : m_names)
+    copyName((value++)->name, valueName);
+  for(uint32_t slot = 0; slot < EXPORT_SLOTS; slot++)
+    new (base + slotsOffset + slot*slotSize) ExportSlot();
+
+  // readers accept the segment once the magic is set
+  header->magic.store(EXPORT_MAGIC, std::memory_order_release);
+
+  m_segment = name;
+  m_memory = memory;
+  m_size = size;
+  m_header = header;
+  m_slots = base + slotsOffset;
+  m_published = 0;
+  m_tick = 0;
+  LOG_INFO("Image export %s: %u input bytes, %u output bytes, %u values", name.c_str(),
+           header->inputSize, header->outputSize, header->valueCount);
+  return true;
+}
+
+void ImageExporter::close(){
+  unmap();
+  m_names.clear();
+  m_signals.clear();
+}
+
+void ImageExporter::unmap(){
+  if(m_header){
+    m_header->magic.store(0, std::memory_order_release);
+    munmap(m_memory, m_size);
+    shm_unlink(m_segment.c_str());
+  }
+  m_memory = nullptr;
+  m_size = 0;
+  m_header = nullptr;
+  m_slots = nullptr;
+}
+
+void ImageExporter::publish(const ProcessImage& image){
+  m_tick++;
+  if(!m_header)
+    return;
+  uint32_t inputSize = m_header->inputSize;
+  uint32_t outputSize = m_header->outputSize;
+  uint8_t* slotBase = m_slots + (m_published % EXPORT_SLOTS)*m_header->slotSize;
+  auto slot = reinterpret_cast<ExportSlot*>(slotBase);
+  uint8_t* data = slotBase + sizeof(ExportSlot);
+
+  // seqlock write side: odd sequence, data, even sequence; readers of this slot retry or take another one
+  slot->sequence.store(2*m_published + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  slot->tick = m_tick;
+  slot->timestamp = int64_t(now.tv_sec)*1000000000 + now.tv_nsec;
+  std::memcpy(data, image.inputData(), inputSize);
+  std::memcpy(data + inputSize, image.outputData(), outputSize);
+  auto values = reinterpret_cast<double*>(slotBase + m_header->slotValuesOffset);
+  for(size_t i = 0; i < m_signals.size(); i++)
+    values[i] = m_signals[i].read(image.inputData());
+  slot->sequence.store(2*m_published + 2, std::memory_order_release);
+
+  m_header->published.store(++m_published, std::memory_order_release);
+}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "rt_export_layout.h"
+#include "rt_process_image.h"
+#include "rt_signal.h"
+
+namespace Example{
+  // Publishes snapshots of the input/output images and of configured values (e.g. axis state) into a POSIX
+  // shared-memory segment for local processes, see rt_export_layout.h and the reader library.
+  // The tick never waits for readers: every slot is protected by a seqlock and readers only read.
+  class ImageExporter
+  {
+    public:
+      ~ImageExporter();
+
+      // Configuration, non-RT; values are added before open()
+      bool addValue(const std::string& name, const SignalRef& signal);
+      bool open(const std::string& name, const ProcessImage& image);
+      // Removes the segment and the values
+      void close();
+      bool isOpen() const { return m_header != nullptr; }
+
+      // RT side, once per tick after the outputs are complete
+      void publish(const ProcessImage& image);
+
+    private:
+      void unmap();
+
+      std::vector<std::string> m_names;
+      std::vector<SignalRef> m_signals;
+      std::string m_segment;
+      void* m_memory = nullptr;
+      size_t m_size = 0;
+      ExportHeader* m_header = nullptr;
+      uint8_t* m_slots = nullptr;
+      uint64_t m_published = 0;
+      uint64_t m_tick = 0;
+  };
+}
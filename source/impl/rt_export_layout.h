@@ -0,0 +1,62 @@
+#pragma once
+//
+// Layout of the shared-memory export of the process image, shared by the RT application (ImageExporter)
+// and the reader library (ImageReader).
+//
+//   ExportHeader | ExportVariable[variableCount] | ExportValue[valueCount] | slot[slotCount]
+//   slot:          ExportSlot | input image | output image | double values[valueCount] at slotValuesOffset
+//
+// The writer fills the slots round-robin. Each slot has its own sequence number (seqlock): odd while it
+// is written, 2*n + 2 once snapshot n (counting from 0) is complete. Readers never write to the segment.
+//
+#include <atomic>
+#include <cstdint>
+
+namespace Example{
+  constexpr uint32_t EXPORT_MAGIC = 0x54524558; // "EXRT"
+  constexpr uint32_t EXPORT_LAYOUT_VERSION = 1;
+  constexpr uint32_t EXPORT_SLOTS = 4;
+  constexpr uint32_t EXPORT_NAME_SIZE = 64;
+  constexpr const char* EXPORT_DEFAULT_NAME = "/snap.sdk-example.image";
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock needs lock-free 64 bit atomics");
+
+  struct alignas(64) ExportHeader
+  {
+    std::atomic<uint32_t> magic;  // cleared when the application unbinds, readers reopen the segment then
+    uint32_t layoutVersion;
+    uint32_t slotCount;
+    uint32_t slotSize;        // bytes per slot including ExportSlot, multiple of 64
+    uint32_t inputSize;
+    uint32_t outputSize;
+    uint32_t variableCount;
+    uint32_t valueCount;
+    uint32_t slotValuesOffset;  // from the start of a slot
+    uint32_t reserved;
+    uint64_t variablesOffset; // from the start of the segment
+    uint64_t valuesOffset;
+    uint64_t slotsOffset;
+    alignas(64) std::atomic<uint64_t> published; // number of completed snapshots
+  };
+
+  struct ExportVariable
+  {
+    char name[EXPORT_NAME_SIZE];
+    uint32_t bitOffset;
+    uint32_t bitSize;
+    uint32_t output;          // 0: input image, 1: output image
+    uint32_t reserved;
+  };
+
+  struct ExportValue
+  {
+    char name[EXPORT_NAME_SIZE];
+  };
+
+  struct alignas(64) ExportSlot
+  {
+    std::atomic<uint64_t> sequence;
+    uint64_t tick;
+    int64_t timestamp;        // CLOCK_MONOTONIC, ns
+  };
+}
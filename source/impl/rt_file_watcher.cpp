@@ -0,0 +1,55 @@
+#include "rt_file_watcher.h"
+#include <chrono>
+#include <filesystem>
+
+namespace Example{
+
+FileWatcher::~FileWatcher(){
+  stop();
+}
+
+void FileWatcher::start(const std::string& path, std::function<void(const std::string&)> changed, uint32_t intervalMs){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_running)
+      return;
+    m_running = true;
+  }
+  m_thread = std::thread(&FileWatcher::run, this, path, std::move(changed), intervalMs);
+}
+
+bool FileWatcher::running() const{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_running;
+}
+
+void FileWatcher::run(std::string path, std::function<void(const std::string&)> changed, uint32_t intervalMs){
+  std::filesystem::file_time_type reported{};
+  std::filesystem::file_time_type seen{};
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while(m_running){
+    std::error_code failure;
+    auto modified = std::filesystem::last_write_time(path, failure);
+    // a changed file is reported once it has not been modified for one interval
+    if(!failure && modified != reported && modified == seen){
+      lock.unlock();
+      changed(path);
+      lock.lock();
+      reported = modified;
+    }
+    if(!failure)
+      seen = modified;
+    m_wake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]{ return !m_running; });
+  }
+}
+
+void FileWatcher::stop(){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_wake.notify_all();
+  if(m_thread.joinable())
+    m_thread.join();
+}
+}
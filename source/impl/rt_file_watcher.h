@@ -0,0 +1,30 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Example{
+  // Calls a handler in its own non-RT thread whenever a file changes, polling the modification time.
+  // A change is reported once the file has not been modified for one interval; files should still be
+  // replaced by rename so they are never read half written.
+  class FileWatcher
+  {
+    public:
+      ~FileWatcher();
+
+      void start(const std::string& path, std::function<void(const std::string&)> changed, uint32_t intervalMs = 500);
+      void stop();
+      bool running() const;
+
+    private:
+      void run(std::string path, std::function<void(const std::string&)> changed, uint32_t intervalMs);
+
+      std::thread m_thread;
+      mutable std::mutex m_mutex;
+      std::condition_variable m_wake;
+      bool m_running = false;
+  };
+}
@@ -0,0 +1,50 @@
+#pragma once
+//
+// C ABI of a user logic module, a shared object that can be replaced while the RT task runs.
+// A module only includes this header and exports
+//
+//   extern "C" const ExampleModule* example_module(void);
+//
+// The host loads it in non-RT code, calls init, warms it up and switches to it at a tick boundary.
+// Increase stateVersion whenever the layout of the state changes, migrate_state of the new module
+// receives the version and the state of the module it replaces.
+//
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXAMPLE_MODULE_ABI_VERSION 1u
+#define EXAMPLE_MODULE_ENTRY "example_module"
+
+// Variables of the unified process image, resolved in init
+typedef struct ExampleModuleImage
+{
+  void* context;
+  // 0 and bit offset/size in the input or output image, -1 if the variable does not exist
+  int (*input)(void* context, const char* name, uint32_t* bitOffset, uint32_t* bitSize);
+  int (*output)(void* context, const char* name, uint32_t* bitOffset, uint32_t* bitSize);
+} ExampleModuleImage;
+
+typedef struct ExampleModule
+{
+  uint32_t abiVersion;   // EXAMPLE_MODULE_ABI_VERSION
+  uint32_t stateVersion; // layout version of the state
+  uint32_t stateSize;    // allocated by the host, zeroed and 64 byte aligned
+  const char* name;
+
+  // non-RT, 0 on success
+  int (*init)(void* state, const ExampleModuleImage* image);
+  // RT, every tick after the inputs are read and before the outputs are written
+  void (*AT)(void* state, const uint8_t* inData);
+  void (*MDT)(void* state, uint8_t* outData);
+  // RT, once in the tick the module takes over; may be NULL. Must not block or allocate.
+  void (*migrate_state)(void* state, const void* previous, uint32_t previousVersion, uint32_t previousSize);
+} ExampleModule;
+
+typedef const ExampleModule* (*ExampleModuleEntry)(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Example{
+  // Bounded multi-producer/multi-consumer ring (per-cell sequence numbers). Producers and consumers only
+  // meet on the cell they claimed, so non-RT threads pushing concurrently do not hold up the RT consumer.
+  // Neither side ever blocks: push fails when the ring is full, pop fails when it is empty.
+  template<typename T, size_t N>
+  class MpmcQueue
+  {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpmcQueue capacity must be a power of two");
+
+    public:
+      MpmcQueue(){
+        for(size_t i = 0; i < N; i++)
+          m_cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+
+      bool push(const T& item){
+        size_t position = m_head.load(std::memory_order_relaxed);
+        for(;;){
+          Cell& cell = m_cells[position & (N - 1)];
+          size_t sequence = cell.sequence.load(std::memory_order_acquire);
+          if(sequence == position){
+            if(m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+              cell.item = item;
+              cell.sequence.store(position + 1, std::memory_order_release);
+              return true;
+            }
+          }
+          else if(sequence < position)
+            return false;
+          else
+            position = m_head.load(std::memory_order_relaxed);
+        }
+      }
+
+      bool pop(T& item){
+        size_t position = m_tail.load(std::memory_order_relaxed);
+        for(;;){
+          Cell& cell = m_cells[position & (N - 1)];
+          size_t sequence = cell.sequence.load(std::memory_order_acquire);
+          if(sequence == position + 1){
+            if(m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+              item = cell.item;
+              cell.sequence.store(position + N, std::memory_order_release);
+              return true;
+            }
+          }
+          else if(sequence < position + 1)
+            return false;
+          else
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+      }
+
+      static constexpr size_t capacity(){ return N; }
+
+    private:
+      struct alignas(64) Cell
+      {
+        std::atomic<size_t> sequence;
+        T item;
+      };
+
+      alignas(64) std::atomic<size_t> m_head{0};
+      alignas(64) std::atomic<size_t> m_tail{0};
+      std::array<Cell, N> m_cells;
+  };
+}
@@ -0,0 +1,75 @@
+#include "rt_parameters.h"
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace Example{
+namespace {
+  bool isInteger(SignalType type){
+    return type != SignalType::Float32 && type != SignalType::Float64;
+  }
+
+  template<typename T>
+  void store(uint8_t* p, double value){
+    T typed = static_cast<T>(value);
+    std::memcpy(p, &typed, sizeof(T));
+  }
+
+  void storeField(void* set, const ParameterField& field, double value){
+    uint8_t* p = static_cast<uint8_t*>(set) + field.offset;
+    switch(field.type)
+    {
+      case SignalType::Int8: store<int8_t>(p, value); break;
+      case SignalType::UInt8: store<uint8_t>(p, value); break;
+      case SignalType::Int16: store<int16_t>(p, value); break;
+      case SignalType::UInt16: store<uint16_t>(p, value); break;
+      case SignalType::Int32: store<int32_t>(p, value); break;
+      case SignalType::UInt32: store<uint32_t>(p, value); break;
+      case SignalType::Float32: store<float>(p, value); break;
+      case SignalType::Float64: store<double>(p, value); break;
+    }
+  }
+}
+
+bool parseParameters(std::istream& source, const std::vector<ParameterField>& fields, void* set, std::string& error){
+  std::vector<std::pair<const ParameterField*, double>> values;
+  std::string text;
+  for(int line = 1; std::getline(source, text); line++){
+    text = text.substr(0, text.find('#'));
+    std::istringstream stream(text);
+    std::vector<std::string> tokens;
+    for(std::string token; stream >> token;)
+      tokens.push_back(token);
+    if(tokens.empty())
+      continue;
+    if(tokens.size() != 3 || tokens[1] != "="){
+      error = "line " + std::to_string(line) + ": expected '<name> = <value>'";
+      return false;
+    }
+    const ParameterField* field = nullptr;
+    for(auto& candidate : fields)
+      if(candidate.name == tokens[0])
+        field = &candidate;
+    if(!field){
+      error = "line " + std::to_string(line) + ": unknown parameter " + tokens[0];
+      return false;
+    }
+    char* end = nullptr;
+    double value = std::strtod(tokens[2].c_str(), &end);
+    if(end == tokens[2].c_str() || *end != '\0' || !std::isfinite(value) ||
+       (isInteger(field->type) && value != std::floor(value))){
+      error = "line " + std::to_string(line) + ": invalid value of " + field->name;
+      return false;
+    }
+    if(value < field->minimum || value > field->maximum){
+      error = "line " + std::to_string(line) + ": " + field->name + " out of range [" +
+              std::to_string(field->minimum) + ", " + std::to_string(field->maximum) + "]";
+      return false;
+    }
+    values.emplace_back(field, value);
+  }
+  for(auto& value : values)
+    storeField(set, *value.first, value.second);
+  return true;
+}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "rt_signal.h"
+#include "rt_triple_buffer.h"
+
+namespace Example{
+  // Named member of a parameter set that can be edited in parameter files, e.g. {"Axis1/Velocity", offsetof(...), ...}
+  struct ParameterField
+  {
+    std::string name;
+    size_t offset;
+    SignalType type;
+    double minimum;
+    double maximum;
+  };
+
+  // Applies "<name> = <value>" lines to a parameter set. Nothing is changed unless all lines are valid.
+  bool parseParameters(std::istream& source, const std::vector<ParameterField>& fields, void* set, std::string& error);
+
+  // Access of RTApplication to the parameter store of the user code
+  class IParameterStore
+  {
+    public:
+      virtual ~IParameterStore() = default;
+      // Non-RT
+      virtual bool load(const std::string& path, std::string& error) = 0;
+      // RT, at the start of the tick
+      virtual bool acquire() = 0;
+  };
+
+  // Parameter sets of type T, edited by non-RT code (parameter files, Data Layer writes, ...) and used by the tick.
+  // publish() computes the derived values of the set (T::derive(), if T has it) and hands the complete set
+  // to the tick through a triple buffer. The tick takes the newest set with acquire() and reads it with get().
+  template<typename T>
+  class ParameterStore:public IParameterStore
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "parameter sets are copied between the buffers");
+
+    public:
+      explicit ParameterStore(std::vector<ParameterField> fields = {}) : m_fields(std::move(fields)){
+        publish(T{});
+        acquire();
+      }
+
+      // Non-RT, any thread
+      T edit() const{
+        std::lock_guard<std::mutex> lock(m_writer);
+        return m_latest;
+      }
+      void publish(const T& set){
+        std::lock_guard<std::mutex> lock(m_writer);
+        publishLocked(set);
+      }
+      bool apply(std::istream& source, std::string& error){
+        std::lock_guard<std::mutex> lock(m_writer);
+        T set = m_latest;
+        if(!parseParameters(source, m_fields, &set, error))
+          return false;
+        publishLocked(set);
+        return true;
+      }
+      bool load(const std::string& path, std::string& error) override{
+        std::ifstream file(path);
+        if(!file){
+          error = "cannot open " + path;
+          return false;
+        }
+        return apply(file, error);
+      }
+
+      // RT
+      bool acquire() override { return m_buffer.update(); }
+      const T& get() const { return m_buffer.front(); }
+
+    private:
+      void publishLocked(const T& set){
+        m_latest = set;
+        if constexpr(requires(T& value){ value.derive(); })
+          m_latest.derive();
+        m_buffer.back() = m_latest;
+        m_buffer.publish();
+      }
+
+      std::vector<ParameterField> m_fields;
+      mutable std::mutex m_writer;  // serializes non-RT editors, never taken by the tick
+      T m_latest{};
+      TripleBuffer<T> m_buffer;
+  };
+}
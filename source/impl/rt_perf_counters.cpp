@@ -0,0 +1,118 @@
+#include "rt_perf_counters.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Example{
+namespace {
+  const char* const COUNTER_NAMES[PERF_COUNTERS] = {"cycles", "instructions", "cache misses", "branch misses"};
+  const uint64_t COUNTER_EVENTS[PERF_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                                                  PERF_COUNT_HW_BRANCH_MISSES};
+
+  int openEvent(uint64_t event, int group){
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event;
+    attr.disabled = group < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, PERF_FLAG_FD_CLOEXEC));
+  }
+}
+
+const char* perfCounterName(PerfCounter counter){
+  return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+PerfCounters::~PerfCounters(){
+  close();
+}
+
+bool PerfCounters::open(){
+  close();
+  for(size_t counter = 0; counter < PERF_COUNTERS; counter++){
+    m_fds[counter] = openEvent(COUNTER_EVENTS[counter], m_fds[0]);
+    if(m_fds[counter] < 0){
+      close();
+      return false;
+    }
+  }
+#if defined(__x86_64__)
+  // rdpmc is allowed if the kernel sets cap_user_rdpmc in the page of every event
+  m_userRead = true;
+  long pageSize = sysconf(_SC_PAGESIZE);
+  for(size_t counter = 0; counter < PERF_COUNTERS; counter++){
+    void* page = mmap(nullptr, pageSize, PROT_READ, MAP_SHARED, m_fds[counter], 0);
+    if(page == MAP_FAILED){
+      m_userRead = false;
+      continue;
+    }
+    m_pages[counter] = static_cast<perf_event_mmap_page*>(page);
+    m_userRead = m_userRead && m_pages[counter]->cap_user_rdpmc;
+  }
+#endif
+  if(ioctl(m_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0){
+    close();
+    return false;
+  }
+  return true;
+}
+
+void PerfCounters::close(){
+  long pageSize = sysconf(_SC_PAGESIZE);
+  for(size_t counter = PERF_COUNTERS; counter-- > 0;){
+    if(m_pages[counter])
+      munmap(m_pages[counter], pageSize);
+    m_pages[counter] = nullptr;
+    if(m_fds[counter] >= 0)
+      ::close(m_fds[counter]);
+    m_fds[counter] = -1;
+  }
+  m_userRead = false;
+}
+
+bool PerfCounters::read(uint64_t values[PERF_COUNTERS]) const{
+  if(m_userRead){
+    for(size_t counter = 0; counter < PERF_COUNTERS; counter++)
+      values[counter] = readUser(counter);
+    return true;
+  }
+  // PERF_FORMAT_GROUP: number of events, then their values in the order they were opened
+  uint64_t group[1 + PERF_COUNTERS];
+  if(m_fds[0] < 0 || ::read(m_fds[0], group, sizeof(group)) != static_cast<ssize_t>(sizeof(group)))
+    return false;
+  for(size_t counter = 0; counter < PERF_COUNTERS; counter++)
+    values[counter] = group[1 + counter];
+  return true;
+}
+
+uint64_t PerfCounters::readUser(size_t counter) const{
+  uint64_t value = 0;
+#if defined(__x86_64__)
+  // the kernel updates the page under a sequence lock when the event is scheduled in or out
+  const volatile perf_event_mmap_page* page = m_pages[counter];
+  uint32_t sequence;
+  do{
+    sequence = page->lock;
+    asm volatile("" ::: "memory");
+    uint32_t index = page->index;
+    value = page->offset;
+    if(index){
+      uint32_t low, high;
+      asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(index - 1));
+      uint32_t width = page->pmc_width;
+      int64_t count = static_cast<int64_t>(uint64_t(high) << 32 | low);
+      count <<= 64 - width;
+      count >>= 64 - width;
+      value += count;
+    }
+    asm volatile("" ::: "memory");
+  } while(page->lock != sequence);
+#endif
+  return value;
+}
+}
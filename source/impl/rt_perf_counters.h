@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+struct perf_event_mmap_page;
+
+namespace Example{
+  enum class PerfCounter : uint8_t
+  {
+    Cycles,
+    Instructions,
+    CacheMisses,  // last level cache
+    BranchMisses
+  };
+  constexpr size_t PERF_COUNTERS = 4;
+  const char* perfCounterName(PerfCounter counter);
+
+  // Hardware performance counters of the calling thread, opened with perf_event_open as one group so the
+  // counts of one read belong together. User space only, which perf_event_paranoid 2 still allows. On x86
+  // the counters are read with rdpmc through the mapped pages of the events, which takes no system call;
+  // otherwise one read() of the group is needed.
+  class PerfCounters
+  {
+    public:
+      ~PerfCounters();
+
+      // On the thread to be counted; false if the CPU, the kernel or its settings do not provide the counters
+      bool open();
+      // From any thread while the counted thread does not read
+      void close();
+      bool isOpen() const { return m_fds[0] >= 0; }
+      bool userRead() const { return m_userRead; }
+
+      // On the counted thread
+      bool read(uint64_t values[PERF_COUNTERS]) const;
+
+    private:
+      uint64_t readUser(size_t counter) const;
+
+      int m_fds[PERF_COUNTERS] = {-1, -1, -1, -1};
+      perf_event_mmap_page* m_pages[PERF_COUNTERS] = {};
+      bool m_userRead = false;
+  };
+}
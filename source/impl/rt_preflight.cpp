@@ -0,0 +1,170 @@
+#include "rt_preflight.h"
+#include "Logger.h"
+#include "worker_pool.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace Example{
+namespace {
+  std::string readFirstLine(const std::string& path){
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+  }
+}
+
+RtPreflight::~RtPreflight(){
+  release();
+}
+
+size_t RtPreflight::run(int32_t dmaLatencyUs, size_t heapReserve){
+  m_findings.clear();
+  lockMemory(heapReserve);
+  holdDmaLatency(dmaLatencyUs);
+  checkKernel();
+  checkIsolation();
+  checkGovernors();
+  checkHugePages();
+  size_t problems = 0;
+  for(auto& finding : m_findings){
+    if(!finding.ok)
+      problems++;
+  }
+  return problems;
+}
+
+void RtPreflight::release(){
+  //the latency request of the process ends when the file is closed
+  if(m_dmaLatency >= 0)
+  {
+    ::close(m_dmaLatency);
+    m_dmaLatency = -1;
+  }
+}
+
+void RtPreflight::touch(void* data, size_t size){
+  long page = sysconf(_SC_PAGESIZE);
+  volatile uint8_t* bytes = static_cast<uint8_t*>(data);
+  for(size_t offset = 0; offset < size; offset += page)
+    bytes[offset] = bytes[offset];
+  if(size)
+    bytes[size - 1] = bytes[size - 1];
+}
+
+void RtPreflight::report(bool ok, const std::string& message){
+  if(ok)
+  {
+    LOG_INFO("Preflight: %s", message.c_str());
+  }
+  else
+  {
+    LOG_WARNING("Preflight: %s", message.c_str());
+  }
+  m_findings.push_back(PreflightFinding{ok, message});
+}
+
+void RtPreflight::lockMemory(size_t heapReserve){
+  if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    rlimit limit{};
+    getrlimit(RLIMIT_MEMLOCK, &limit);
+    report(false, std::string("memory not locked: ") + std::strerror(errno) + ", RLIMIT_MEMLOCK " +
+                  (limit.rlim_cur == RLIM_INFINITY ? std::string("unlimited") : std::to_string(limit.rlim_cur)));
+    return;
+  }
+  if(!heapReserve)
+  {
+    report(true, "memory locked");
+    return;
+  }
+  //freed memory stays in the heap and large blocks come from it instead of fresh mappings,
+  //so the reserve touched here serves the allocations made when the callable is bound
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+  void* reserve = std::malloc(heapReserve);
+  if(!reserve)
+  {
+    report(false, "memory locked, heap reserve of " + std::to_string(heapReserve >> 20) + " MiB not allocated");
+    return;
+  }
+  touch(reserve, heapReserve);
+  std::free(reserve);
+  report(true, "memory locked, heap reserve " + std::to_string(heapReserve >> 20) + " MiB");
+}
+
+void RtPreflight::holdDmaLatency(int32_t dmaLatencyUs){
+  release();
+  if(dmaLatencyUs < 0)
+    return;
+  int file = ::open("/dev/cpu_dma_latency", O_RDWR | O_CLOEXEC);
+  if(file < 0)
+  {
+    report(false, std::string("/dev/cpu_dma_latency not opened: ") + std::strerror(errno));
+    return;
+  }
+  if(::write(file, &dmaLatencyUs, sizeof(dmaLatencyUs)) != sizeof(dmaLatencyUs))
+  {
+    report(false, std::string("/dev/cpu_dma_latency not written: ") + std::strerror(errno));
+    ::close(file);
+    return;
+  }
+  m_dmaLatency = file;
+  report(true, "wakeup latency held at " + std::to_string(dmaLatencyUs) + " us");
+}
+
+void RtPreflight::checkKernel(){
+  utsname name{};
+  uname(&name);
+  std::string version = name.version;
+  bool realtime = readFirstLine("/sys/kernel/realtime") == "1" || version.find("PREEMPT_RT") != std::string::npos ||
+                  version.find("PREEMPT RT") != std::string::npos;
+  report(realtime, std::string(realtime ? "real-time kernel " : "no real-time kernel: ") + name.release + " " + version);
+}
+
+void RtPreflight::checkIsolation(){
+  std::string isolated = readFirstLine("/sys/devices/system/cpu/isolated");
+  if(isolated.empty())
+  {
+    report(false, "no isolated cores, the tick shares its core with other tasks");
+    return;
+  }
+  std::string nohz = readFirstLine("/sys/devices/system/cpu/nohz_full");
+  report(true, "isolated cores " + isolated + (nohz.empty() || nohz == "(null)" ? std::string(", no nohz_full cores") : ", nohz_full " + nohz));
+}
+
+void RtPreflight::checkGovernors(){
+  auto online = WorkerPool::parseCores(readFirstLine("/sys/devices/system/cpu/online"));
+  std::string slow;
+  size_t checked = 0;
+  for(int core : online){
+    std::string governor = readFirstLine("/sys/devices/system/cpu/cpu" + std::to_string(core) + "/cpufreq/scaling_governor");
+    if(governor.empty())
+      continue;
+    checked++;
+    if(governor != "performance")
+      slow += (slow.empty() ? "" : ", ") + std::to_string(core) + ":" + governor;
+  }
+  if(!checked)
+    report(true, "no frequency scaling");
+  else if(slow.empty())
+    report(true, "performance governor on all cores");
+  else
+    report(false, "cores not at the performance governor " + slow);
+}
+
+void RtPreflight::checkHugePages(){
+  //khugepaged compacts and collapses pages in the background, the faults it causes are not bounded
+  std::string hugePages = readFirstLine("/sys/kernel/mm/transparent_hugepage/enabled");
+  if(hugePages.find("[always]") != std::string::npos)
+    report(false, "transparent huge pages always enabled");
+}
+}
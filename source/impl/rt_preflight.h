@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Example{
+  // Result of one check of the preflight
+  struct PreflightFinding
+  {
+    bool ok;
+    std::string message;
+  };
+
+  // Preparation of the process for the tick, run by the bundle before the callable is registered, so the
+  // first ticks run like the steady state. It locks all current and future memory of the process; the kernel
+  // then populates every later mapping when it is made, and the buffers and binding tables built at bind
+  // time are served from a heap reserve that the preflight touches once. Nothing is touched at bind time.
+  // It holds /dev/cpu_dma_latency open at the given value until release(), which keeps the cores out of
+  // deep idle states. It checks the kernel, the isolated cores, the frequency governors and transparent
+  // huge pages. The findings go to the trace. Memory locking and the heap settings apply to the whole
+  // process and are kept after release().
+  class RtPreflight
+  {
+    public:
+      ~RtPreflight();
+
+      // Non-RT; dmaLatencyUs < 0 leaves the wakeup latency as it is; returns the number of problems found
+      size_t run(int32_t dmaLatencyUs, size_t heapReserve);
+      void release();
+      const std::vector<PreflightFinding>& findings() const { return m_findings; }
+
+    private:
+      // Writes every page of the heap reserve once
+      static void touch(void* data, size_t size);
+      void report(bool ok, const std::string& message);
+      void lockMemory(size_t heapReserve);
+      void holdDmaLatency(int32_t dmaLatencyUs);
+      void checkKernel();
+      void checkIsolation();
+      void checkGovernors();
+      void checkHugePages();
+
+      int m_dmaLatency = -1;
+      std::vector<PreflightFinding> m_findings;
+  };
+}
@@ -0,0 +1,278 @@
+#include "rt_process_image.h"
+#include "Logger.h"
+#include "rt_timeline.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Example{
+namespace {
+  // sources start on their own cache line in the unified images
+  constexpr uint32_t SOURCE_ALIGNMENT = 64;
+  // bound input ranges closer than this are copied as one, reading a few extra bytes is cheaper than another call
+  constexpr uint32_t INPUT_GAP = 64;
+  // outputs are compared in blocks of this size, changed blocks closer than DIRTY_GAP are written as one
+  constexpr uint32_t DIRTY_BLOCK = 8;
+  constexpr uint32_t DIRTY_GAP = 64;
+
+  uint32_t alignUp(size_t value){
+    return static_cast<uint32_t>((value + SOURCE_ALIGNMENT - 1)/SOURCE_ALIGNMENT*SOURCE_ALIGNMENT);
+  }
+}
+
+size_t ProcessImage::imageSize(const std::shared_ptr<comm::datalayer::IMemoryUser>& memory, const ImageMap& map){
+  size_t size = 0;
+  if(memory && memory->getSize(size) == DL_OK && size != 0)
+    return size;
+  // fall back to the end of the last variable of the map
+  for(auto& variable : map)
+    size = std::max<size_t>(size, (variable.second.bitOffset + variable.second.bitSize + 7)/8);
+  return size;
+}
+
+void ProcessImage::bind(const std::vector<RealtimeSource>& sources){
+  clear();
+  uint32_t inputBase = 0;
+  uint32_t outputBase = 0;
+  for(auto& source : sources){
+    Source bound{};
+    bound.inputs = source.inputs;
+    bound.outputs = source.outputs;
+    bound.inputRevision = source.inputRevision;
+    bound.outputRevision = source.outputRevision;
+    bound.inputBase = inputBase;
+    bound.outputBase = outputBase;
+    bound.inputSize = source.inputs ? imageSize(source.inputs, source.inputMap) : 0;
+    bound.outputSize = source.outputs ? imageSize(source.outputs, source.outputMap) : 0;
+    // a direction without memory has no room in the image, its variables do not exist
+    if(source.inputs)
+      for(auto& variable : source.inputMap)
+        m_inputMap.insert(source.prefix + std::string(variable.first), ImageVariable{variable.second.bitOffset + inputBase*8, variable.second.bitSize});
+    if(source.outputs)
+      for(auto& variable : source.outputMap)
+        m_outputMap.insert(source.prefix + std::string(variable.first), ImageVariable{variable.second.bitOffset + outputBase*8, variable.second.bitSize});
+    inputBase = alignUp(inputBase + bound.inputSize);
+    outputBase = alignUp(outputBase + bound.outputSize);
+    m_sources.push_back(bound);
+  }
+  m_inputMap.sort();
+  m_outputMap.sort();
+  m_inputImage.assign(inputBase, 0);
+  m_outputImage.assign(outputBase, 0);
+  m_inputUsed.assign(inputBase, 0);
+  m_outputUsed.assign(outputBase, 0);
+
+  // start from the current outputs, so bound values the user code does not set keep their value
+  for(auto& source : m_sources){
+    uint8_t* data;
+    if(source.outputs && source.outputs->beginAccess(data, source.outputRevision) == DL_OK)
+      std::memcpy(&m_outputImage[source.outputBase], data, source.outputSize);
+    if(source.outputs)
+      source.outputs->endAccess();
+  }
+  m_outputCommitted = m_outputImage;
+}
+
+void ProcessImage::clear(){
+  m_sources.clear();
+  m_inputMap.clear();
+  m_outputMap.clear();
+  m_inputImage.clear();
+  m_outputImage.clear();
+  m_outputCommitted.clear();
+  m_inputUsed.clear();
+  m_outputUsed.clear();
+  m_plan.store(nullptr, std::memory_order_release);
+  m_planInUse.store(nullptr, std::memory_order_release);
+  m_tickPlan = nullptr;
+  m_plans.clear();
+}
+
+void ProcessImage::mark(std::vector<uint8_t>& used, const ImageVariable& variable){
+  for(uint32_t bit = variable.bitOffset; bit < variable.bitOffset + std::max<uint32_t>(variable.bitSize, 1); bit++){
+    if(bit/8 < used.size())
+      used[bit/8] |= static_cast<uint8_t>(1u << (bit % 8));
+  }
+}
+
+const ImageVariable* ProcessImage::input(std::string_view name){
+  auto variable = m_inputMap.find(name);
+  if(variable == m_inputMap.end())
+    return nullptr;
+  std::lock_guard<std::mutex> guard(m_usedLock);
+  mark(m_inputUsed, variable->second);
+  return &variable->second;
+}
+
+const ImageVariable* ProcessImage::output(std::string_view name){
+  auto variable = m_outputMap.find(name);
+  if(variable == m_outputMap.end())
+    return nullptr;
+  std::lock_guard<std::mutex> guard(m_usedLock);
+  mark(m_outputUsed, variable->second);
+  return &variable->second;
+}
+
+void ProcessImage::finalize(){
+  std::lock_guard<std::mutex> guard(m_usedLock);
+  auto plan = std::make_unique<Plan>();
+  plan->sources.resize(m_sources.size());
+  size_t inputBytes = 0;
+  size_t outputBytes = 0;
+  for(size_t index = 0; index < m_sources.size(); index++){
+    const Source& source = m_sources[index];
+    SourcePlan& sourcePlan = plan->sources[index];
+
+    // inputs: whole bytes, neighbouring ranges merged
+    for(uint32_t offset = 0; offset < source.inputSize; offset++){
+      if(m_inputUsed[source.inputBase + offset] == 0)
+        continue;
+      if(!sourcePlan.inputSegments.empty()){
+        auto& last = sourcePlan.inputSegments.back();
+        if(offset - (last.offset + last.length) <= INPUT_GAP){
+          last.length = offset + 1 - last.offset;
+          continue;
+        }
+      }
+      sourcePlan.inputSegments.push_back(Segment{offset, 1, 0xFF});
+    }
+
+    // outputs: runs of whole bytes, partially bound bytes on their own with a bit mask
+    for(uint32_t offset = 0; offset < source.outputSize; offset++){
+      uint8_t used = m_outputUsed[source.outputBase + offset];
+      if(used == 0)
+        continue;
+      if(used == 0xFF && !sourcePlan.outputSegments.empty()){
+        auto& last = sourcePlan.outputSegments.back();
+        if(last.mask == 0xFF && last.offset + last.length == offset){
+          last.length++;
+          continue;
+        }
+      }
+      sourcePlan.outputSegments.push_back(Segment{offset, 1, used});
+    }
+
+    size_t dirtyMax = 0;
+    for(auto& segment : sourcePlan.inputSegments)
+      inputBytes += segment.length;
+    for(auto& segment : sourcePlan.outputSegments){
+      outputBytes += segment.length;
+      dirtyMax += (segment.length + DIRTY_BLOCK - 1)/DIRTY_BLOCK;
+    }
+    sourcePlan.dirtySegments.resize(dirtyMax);
+  }
+
+  m_plans.push_back(std::move(plan));
+  m_plan.store(m_plans.back().get(), std::memory_order_release);
+  // the tick only moves on to newer plans, everything before the one it was last seen with is unused
+  auto inUse = std::find_if(m_plans.begin(), m_plans.end(), [&](const std::unique_ptr<Plan>& entry){
+    return entry.get() == m_planInUse.load(std::memory_order_acquire);
+  });
+  if(inUse != m_plans.end())
+    m_plans.erase(m_plans.begin(), inUse);
+  LOG_INFO("Process image: %zu sources, %zu input bytes and %zu output bytes copied per tick", m_sources.size(), inputBytes, outputBytes);
+}
+
+bool ProcessImage::readInputs(){
+  m_tickPlan = m_plan.load(std::memory_order_acquire);
+  m_planInUse.store(m_tickPlan, std::memory_order_release);
+  // no source provides inputs, there is nothing the AT could work on
+  if(m_inputImage.empty())
+    return false;
+  if(!m_tickPlan)
+    return true;
+  bool result = true;
+  for(size_t index = 0; index < m_sources.size(); index++){
+    const Source& source = m_sources[index];
+    const SourcePlan& plan = m_tickPlan->sources[index];
+    if(!source.inputs || plan.inputSegments.empty())
+      continue;
+    TimelineScope access("input access");
+    uint8_t* data;
+    if(source.inputs->beginAccess(data, source.inputRevision) == DL_OK){
+      uint8_t* image = &m_inputImage[source.inputBase];
+      for(auto& segment : plan.inputSegments)
+        std::memcpy(image + segment.offset, data + segment.offset, segment.length);
+    }
+    else{
+      result = false;
+    }
+    source.inputs->endAccess();
+  }
+  return result;
+}
+
+size_t ProcessImage::collectDirty(const Source& source, SourcePlan& plan){
+  const uint8_t* image = &m_outputImage[source.outputBase];
+  const uint8_t* committed = &m_outputCommitted[source.outputBase];
+  size_t count = 0;
+  for(auto& segment : plan.outputSegments){
+    if(segment.mask != 0xFF){
+      if((image[segment.offset] ^ committed[segment.offset]) & segment.mask)
+        plan.dirtySegments[count++] = segment;
+      continue;
+    }
+    // the gap between two changed blocks of one segment is bound as well and may be written with them
+    size_t first = count;
+    for(uint32_t offset = segment.offset; offset < segment.offset + segment.length; offset += DIRTY_BLOCK){
+      uint32_t length = std::min(DIRTY_BLOCK, segment.offset + segment.length - offset);
+      if(std::memcmp(image + offset, committed + offset, length) == 0)
+        continue;
+      if(count > first){
+        auto& last = plan.dirtySegments[count - 1];
+        if(offset - (last.offset + last.length) < DIRTY_GAP){
+          last.length = offset + length - last.offset;
+          continue;
+        }
+      }
+      plan.dirtySegments[count++] = Segment{offset, length, 0xFF};
+    }
+  }
+  return count;
+}
+
+bool ProcessImage::writeOutputs(){
+  bool result = true;
+  m_committedBytes = 0;
+  if(m_outputImage.empty())
+    return false;
+  if(!m_tickPlan)
+    m_tickPlan = m_plan.load(std::memory_order_acquire);
+  if(!m_tickPlan)
+    return true;
+  for(size_t sourceIndex = 0; sourceIndex < m_sources.size(); sourceIndex++){
+    const Source& source = m_sources[sourceIndex];
+    SourcePlan& plan = m_tickPlan->sources[sourceIndex];
+    if(!source.outputs || plan.outputSegments.empty())
+      continue;
+    // unchanged sources are not accessed at all
+    size_t dirty = collectDirty(source, plan);
+    if(dirty == 0)
+      continue;
+    TimelineScope access("output access");
+    uint8_t* data;
+    if(source.outputs->beginAccess(data, source.outputRevision) == DL_OK){
+      const uint8_t* image = &m_outputImage[source.outputBase];
+      for(size_t index = 0; index < dirty; index++){
+        auto& segment = plan.dirtySegments[index];
+        if(segment.mask == 0xFF)
+          std::memcpy(data + segment.offset, image + segment.offset, segment.length);
+        else
+          data[segment.offset] = static_cast<uint8_t>((data[segment.offset] & ~segment.mask) | (image[segment.offset] & segment.mask));
+      }
+      source.outputs->endAccess();
+      // only what reached the source counts as committed, failed ranges are retried next tick
+      uint8_t* committed = &m_outputCommitted[source.outputBase];
+      for(size_t index = 0; index < dirty; index++){
+        auto& segment = plan.dirtySegments[index];
+        std::memcpy(committed + segment.offset, image + segment.offset, segment.length);
+        m_committedBytes += segment.length;
+      }
+    }
+    else{
+      source.outputs->endAccess();
+      result = false;
+    }
+  }
+  return result;
+}
+}
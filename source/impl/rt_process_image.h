@@ -0,0 +1,125 @@
+#pragma once
+#include "comm/datalayer/datalayer.h"
+#include "rt_containers.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Example{
+  struct ImageVariable
+  {
+    uint32_t bitOffset = 0;
+    uint32_t bitSize = 0;
+    uint32_t byteOffset() const { return bitOffset/8; }
+  };
+  // Sorted by name; the user code looks variables up with string_view keys without building strings
+  typedef FlatMap<ImageVariable> ImageMap;
+
+  // Data Layer address of a realtime_data memory pair, e.g. an EtherCAT master instance or another app.
+  // The prefix is prepended to its variable names in the unified binding.
+  struct RealtimeSourceAddress
+  {
+    std::string address;
+    std::string prefix;
+  };
+
+  // An opened realtime_data memory pair, either direction may be missing
+  struct RealtimeSource
+  {
+    std::string prefix;
+    std::shared_ptr<comm::datalayer::IMemoryUser> inputs;
+    ImageMap inputMap;
+    uint32_t inputRevision = 0;
+    std::shared_ptr<comm::datalayer::IMemoryUser> outputs;
+    ImageMap outputMap;
+    uint32_t outputRevision = 0;
+  };
+
+  // Unified input and output image over all realtime_data sources.
+  // The tick works on local copies: every source is accessed once for the inputs at the start and once
+  // for the outputs at the end, and only for as long as it takes to copy the bound ranges.
+  // Outputs are compared with the values committed last; only the changed ranges are written, merged
+  // and in offset order, and a source without changes is not accessed at all.
+  class ProcessImage
+  {
+    public:
+      // Binding, non-RT
+      // A direction whose memory is missing contributes no variables
+      void bind(const std::vector<RealtimeSource>& sources);
+      void clear();
+      const ImageMap& inputMap() const { return m_inputMap; }
+      const ImageMap& outputMap() const { return m_outputMap; }
+      // Look up a variable and add it to the ranges copied each tick, nullptr if it does not exist.
+      // Changed outputs are written back to their source, bit variables without touching the neighbouring bits.
+      // Safe from several non-RT threads, e.g. the loaders of the active and the shadow module.
+      const ImageVariable* input(std::string_view name);
+      const ImageVariable* output(std::string_view name);
+      // Builds the copy plan, called after all variables are bound. May be called again while the tick runs
+      // to add variables bound later; the new plan is picked up by the next readInputs().
+      void finalize();
+      size_t sourceCount() const { return m_sources.size(); }
+
+      // RT side; false if a source could not be accessed or no source backs the image
+      bool readInputs();
+      bool writeOutputs();
+      const uint8_t* inputData() const { return m_inputImage.data(); }
+      uint8_t* outputData() { return m_outputImage.data(); }
+      const uint8_t* outputData() const { return m_outputImage.data(); }
+      size_t inputSize() const { return m_inputImage.size(); }
+      size_t outputSize() const { return m_outputImage.size(); }
+      // Bytes written to the sources by the last writeOutputs()
+      size_t committedBytes() const { return m_committedBytes; }
+
+    private:
+      struct Segment
+      {
+        uint32_t offset; // in the memory of the source
+        uint32_t length;
+        uint8_t mask;    // bits to write if length is 1, 0xFF for whole bytes
+      };
+      struct Source
+      {
+        std::shared_ptr<comm::datalayer::IMemoryUser> inputs;
+        std::shared_ptr<comm::datalayer::IMemoryUser> outputs;
+        uint32_t inputRevision;
+        uint32_t outputRevision;
+        uint32_t inputBase;  // offset in the unified input image
+        uint32_t outputBase; // offset in the unified output image
+        size_t inputSize;
+        size_t outputSize;
+      };
+      struct SourcePlan
+      {
+        std::vector<Segment> inputSegments;
+        std::vector<Segment> outputSegments;
+        std::vector<Segment> dirtySegments; // preallocated for the worst case, filled each tick
+      };
+      struct Plan
+      {
+        std::vector<SourcePlan> sources;
+      };
+
+      static size_t imageSize(const std::shared_ptr<comm::datalayer::IMemoryUser>& memory, const ImageMap& map);
+      static void mark(std::vector<uint8_t>& used, const ImageVariable& variable);
+      size_t collectDirty(const Source& source, SourcePlan& plan);
+
+      std::vector<Source> m_sources;
+      ImageMap m_inputMap;
+      ImageMap m_outputMap;
+      std::vector<uint8_t> m_inputImage;
+      std::vector<uint8_t> m_outputImage;
+      std::vector<uint8_t> m_outputCommitted; // outputs as last written to the sources
+      std::vector<uint8_t> m_inputUsed;  // bound bits per byte of the unified images
+      std::vector<uint8_t> m_outputUsed;
+      std::mutex m_usedLock; // non-RT: marking of used bits and plan building
+      size_t m_committedBytes = 0;
+      // plans in publishing order; older ones are released once the tick uses a newer one
+      std::vector<std::unique_ptr<Plan>> m_plans;
+      std::atomic<Plan*> m_plan{nullptr};
+      std::atomic<Plan*> m_planInUse{nullptr};
+      Plan* m_tickPlan = nullptr; // RT: plan of the running tick
+  };
+}
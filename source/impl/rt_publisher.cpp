@@ -0,0 +1,161 @@
+#include "rt_publisher.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Example{
+namespace {
+  uint32_t typeSize(SignalType type){
+    switch(type)
+    {
+      case SignalType::Int8:
+      case SignalType::UInt8: return 1;
+      case SignalType::Int16:
+      case SignalType::UInt16: return 2;
+      case SignalType::Int32:
+      case SignalType::UInt32:
+      case SignalType::Float32: return 4;
+      case SignalType::Float64: return 8;
+    }
+    return 0;
+  }
+
+  const char* typeName(SignalType type){
+    switch(type)
+    {
+      case SignalType::Int8: return "int8";
+      case SignalType::UInt8: return "uint8";
+      case SignalType::Int16: return "int16";
+      case SignalType::UInt16: return "uint16";
+      case SignalType::Int32: return "int32";
+      case SignalType::UInt32: return "uint32";
+      case SignalType::Float32: return "float32";
+      case SignalType::Float64: return "float64";
+    }
+    return "";
+  }
+
+  // FNV-1a over names, offsets and types; the revision only changes when the layout does
+  uint32_t hash(uint32_t value, const void* data, size_t size){
+    auto bytes = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; i++)
+      value = (value ^ bytes[i])*16777619u;
+    return value;
+  }
+}
+
+RealtimePublisher::~RealtimePublisher(){
+  destroy();
+}
+
+bool RealtimePublisher::addValue(const std::string& name, const SignalRef& signal){
+  if(m_memory)
+    return false;
+  m_names.push_back(name);
+  m_values.push_back(Value{signal, 0, typeSize(signal.type)});
+  return true;
+}
+
+void RealtimePublisher::layout(){
+  // every value is aligned to its size, so consumers can read it in place
+  uint32_t offset = 0;
+  uint32_t revision = 2166136261u;
+  for(size_t i = 0; i < m_values.size(); i++){
+    Value& value = m_values[i];
+    offset = (offset + value.size - 1)/value.size*value.size;
+    value.offset = offset;
+    offset += value.size;
+    revision = hash(revision, m_names[i].data(), m_names[i].size());
+    revision = hash(revision, &value.offset, sizeof(value.offset));
+    revision = hash(revision, &value.signal.type, sizeof(value.signal.type));
+  }
+  m_size = std::max<uint32_t>(offset, 1);
+  // revision 0 is never valid
+  m_revision = revision ? revision : 1;
+}
+
+bool RealtimePublisher::create(comm::datalayer::IDataLayerFactory3* factory, comm::datalayer::IProvider* provider, const std::string& address){
+  deleteMemory();
+  if(!factory || m_values.empty())
+    return false;
+  layout();
+  std::shared_ptr<comm::datalayer::IMemoryOwner> memory;
+  auto result = factory->createMemorySync(memory, address + "/input", provider, m_size, comm::datalayer::MemoryType_Input);
+  if(result != DL_OK || !memory){
+    LOG_ERROR("Realtime data %s/input not created: %s", address.c_str(), result.toString());
+    return false;
+  }
+  m_factory = factory;
+  m_memory = memory;
+  return setMap();
+}
+
+bool RealtimePublisher::attach(const std::shared_ptr<comm::datalayer::IMemoryOwner>& memory){
+  deleteMemory();
+  if(!memory || m_values.empty())
+    return false;
+  layout();
+  m_memory = memory;
+  return setMap();
+}
+
+bool RealtimePublisher::setMap(){
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<flatbuffers::Offset<comm::datalayer::Variable>> variables;
+  for(size_t i = 0; i < m_values.size(); i++)
+    variables.push_back(comm::datalayer::CreateVariableDirect(builder, m_names[i].c_str(), m_values[i].offset*8, m_values[i].size*8,
+                                                              typeName(m_values[i].signal.type)));
+  builder.Finish(comm::datalayer::CreateMemoryMapDirect(builder, &variables, m_revision, static_cast<uint32_t>(m_size)));
+  comm::datalayer::Variant map;
+  map.copyFlatbuffers(builder);
+  if(m_memory->setMap(map) != DL_OK){
+    LOG_ERROR("Map of the published realtime data not set");
+    deleteMemory();
+    return false;
+  }
+
+  // zero the memory once, this also faults in the pages before the tick writes them
+  uint8_t* data;
+  if(m_memory->beginAccess(data, m_revision) == DL_OK)
+    std::memset(data, 0, m_size);
+  m_memory->endAccess();
+  LOG_INFO("Realtime data published: %zu values, %zu bytes, revision %u", m_values.size(), m_size, m_revision);
+  return true;
+}
+
+void RealtimePublisher::deleteMemory(){
+  if(m_memory && m_factory)
+    m_factory->deleteMemorySync(m_memory);
+  m_memory = nullptr;
+  m_factory = nullptr;
+}
+
+void RealtimePublisher::destroy(){
+  deleteMemory();
+  m_names.clear();
+  m_values.clear();
+  m_size = 0;
+  m_revision = 0;
+}
+
+int64_t RealtimePublisher::offsetOf(const std::string& name) const{
+  auto found = std::find(m_names.begin(), m_names.end(), name);
+  if(found == m_names.end())
+    return -1;
+  return m_values[found - m_names.begin()].offset;
+}
+
+bool RealtimePublisher::publish(const uint8_t* inData){
+  if(!m_memory)
+    return false;
+  uint8_t* data;
+  if(m_memory->beginAccess(data, m_revision) != DL_OK){
+    m_memory->endAccess();
+    return false;
+  }
+  for(const Value& value : m_values)
+    std::memcpy(data + value.offset, (value.signal.address ? value.signal.address : inData) + value.signal.offset, value.size);
+  m_memory->endAccess();
+  return true;
+}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "comm/datalayer/datalayer.h"
+#include "rt_signal.h"
+
+namespace Example{
+  constexpr const char* PUBLISH_DEFAULT_ADDRESS = "sdk-example-rt/realtime_data";
+
+  // Values of the user code (filtered feedback, setpoints, ...) published as realtime_data memory owned by
+  // this app. Other RT apps, e.g. the PLC, open <address>/input and read <address>/input/map the same way
+  // this app binds the EtherCAT master, and get the values of the tick in which they were written.
+  class RealtimePublisher
+  {
+    public:
+      ~RealtimePublisher();
+
+      // Configuration, non-RT; values are added before create()
+      bool addValue(const std::string& name, const SignalRef& signal);
+      // Creates the memory with its map; the provider registers the nodes of the memory
+      bool create(comm::datalayer::IDataLayerFactory3* factory, comm::datalayer::IProvider* provider, const std::string& address);
+      // Takes an already created memory, e.g. an in-process one
+      bool attach(const std::shared_ptr<comm::datalayer::IMemoryOwner>& memory);
+      // Deletes the memory and removes the values, the tick must not run any more
+      void destroy();
+      bool isCreated() const { return m_memory != nullptr; }
+      bool empty() const { return m_values.empty(); }
+      // Byte offset of a value in the published memory, -1 if there is no such value
+      int64_t offsetOf(const std::string& name) const;
+      size_t size() const { return m_size; }
+      uint32_t revision() const { return m_revision; }
+
+      // RT side, once per tick after MDT
+      bool publish(const uint8_t* inData);
+
+    private:
+      struct Value
+      {
+        SignalRef signal;
+        uint32_t offset; // in the published memory
+        uint32_t size;
+      };
+
+      void layout();
+      bool setMap();
+      // Deletes the memory only, the values stay configured for the next create() or attach()
+      void deleteMemory();
+
+      comm::datalayer::IDataLayerFactory3* m_factory = nullptr;
+      std::shared_ptr<comm::datalayer::IMemoryOwner> m_memory;
+      std::vector<std::string> m_names;
+      std::vector<Value> m_values;
+      size_t m_size = 0;
+      uint32_t m_revision = 0;
+  };
+}
@@ -0,0 +1,208 @@
+#include "rt_retained.h"
+#include "rt_timeline.h"
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Example{
+namespace {
+  constexpr uint64_t RETAINED_MAGIC = 0x4e49415445524458ull; // "XDRETAIN"
+  constexpr uint32_t RETAINED_LAYOUT = 1;
+  constexpr size_t HEADER_SIZE = 64;
+  constexpr uint32_t COPIES = 2;
+
+  struct RetainedHeader
+  {
+    uint64_t magic;
+    uint32_t layoutVersion;
+    uint32_t stride;       // bytes per copy
+  };
+
+  // followed by the state
+  struct RetainedCopy
+  {
+    uint64_t sequence;     // 0: never written
+    uint32_t version;      // of the state
+    uint32_t size;
+    uint32_t checksum;     // over sequence, version, size and state
+    uint32_t reserved;
+    int64_t timestamp;     // CLOCK_REALTIME, ns
+  };
+
+  uint32_t strideOf(uint32_t size){
+    return static_cast<uint32_t>((sizeof(RetainedCopy) + size + 63)/64*64);
+  }
+
+  uint32_t fnv(uint32_t value, const void* data, size_t size){
+    auto bytes = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; i++)
+      value = (value ^ bytes[i])*16777619u;
+    return value;
+  }
+
+  uint32_t checksum(const RetainedCopy& copy, const void* data){
+    uint32_t value = fnv(2166136261u, &copy.sequence, sizeof(copy.sequence));
+    value = fnv(value, &copy.version, sizeof(copy.version));
+    value = fnv(value, &copy.size, sizeof(copy.size));
+    return fnv(value, data, copy.size);
+  }
+
+  bool readAll(int fd, void* data, size_t size, off_t offset){
+    auto bytes = static_cast<uint8_t*>(data);
+    while(size){
+      ssize_t done = pread(fd, bytes, size, offset);
+      if(done <= 0)
+        return false;
+      bytes += done;
+      size -= done;
+      offset += done;
+    }
+    return true;
+  }
+}
+
+StatePersistence::~StatePersistence(){
+  close();
+}
+
+bool StatePersistence::open(const std::string& path, IRetainedState& state, std::string& error){
+  close();
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if(fd < 0){
+    error = "cannot open " + path + ": " + strerror(errno);
+    return false;
+  }
+
+  // newest valid copy of the existing file, whatever size the state had then
+  bool restored = false;
+  m_sequence = 0;
+  error = "no stored state";
+  struct stat status{};
+  RetainedHeader header{};
+  if(fstat(fd, &status) == 0 && status.st_size >= static_cast<off_t>(HEADER_SIZE) && readAll(fd, &header, sizeof(header), 0)){
+    if(header.magic != RETAINED_MAGIC || header.layoutVersion != RETAINED_LAYOUT || header.stride < sizeof(RetainedCopy))
+      error = "not a retained state file";
+    else if(status.st_size < static_cast<off_t>(HEADER_SIZE + COPIES*size_t(header.stride)))
+      error = "file is truncated";
+    else{
+      std::vector<uint8_t> copies(COPIES*size_t(header.stride));
+      const RetainedCopy* newest = nullptr;
+      if(readAll(fd, copies.data(), copies.size(), HEADER_SIZE)){
+        for(uint32_t index = 0; index < COPIES; index++){
+          auto copy = reinterpret_cast<const RetainedCopy*>(&copies[index*size_t(header.stride)]);
+          if(copy->sequence == 0 || copy->size > header.stride - sizeof(RetainedCopy) || checksum(*copy, copy + 1) != copy->checksum)
+            continue;
+          if(!newest || copy->sequence > newest->sequence)
+            newest = copy;
+        }
+      }
+      if(!newest)
+        error = "no valid copy";
+      else{
+        m_sequence = newest->sequence;
+        restored = state.restore(newest + 1, newest->size, newest->version);
+        if(!restored)
+          error = "stored version " + std::to_string(newest->version) + " with " + std::to_string(newest->size) + " bytes not accepted";
+      }
+    }
+  }
+
+  // lay the file out for the current state; a changed stride invalidates the copies of the old layout
+  uint32_t stride = strideOf(state.size());
+  size_t size = HEADER_SIZE + COPIES*size_t(stride);
+  bool relayout = status.st_size != static_cast<off_t>(size) || header.magic != RETAINED_MAGIC || header.stride != stride;
+  if(relayout && ftruncate(fd, 0) != 0){
+    error = std::string("cannot truncate: ") + strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  if(ftruncate(fd, size) != 0){
+    error = std::string("cannot resize: ") + strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(memory == MAP_FAILED){
+    error = std::string("cannot map: ") + strerror(errno);
+    return false;
+  }
+  m_memory = static_cast<uint8_t*>(memory);
+  m_size = size;
+  m_state = &state;
+  m_scratch.assign(state.size(), 0);
+  auto mapped = reinterpret_cast<RetainedHeader*>(m_memory);
+  mapped->magic = RETAINED_MAGIC;
+  mapped->layoutVersion = RETAINED_LAYOUT;
+  mapped->stride = stride;
+
+  // store the state the tick starts with right away, before the tick runs this thread is its only writer
+  state.capture();
+  flush();
+  return restored;
+}
+
+void StatePersistence::start(uint32_t intervalMs){
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(m_running || !m_memory)
+    return;
+  m_running = true;
+  m_thread = std::thread(&StatePersistence::run, this, intervalMs ? intervalMs : 1);
+}
+
+void StatePersistence::run(uint32_t intervalMs){
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while(m_running){
+    m_wake.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]{ return !m_running; });
+    flush();
+  }
+}
+
+bool StatePersistence::flush(){
+  TimelineScope scope("retained flush");
+  if(!m_memory || !m_state->snapshot(m_scratch.data()))
+    return false;
+  auto header = reinterpret_cast<const RetainedHeader*>(m_memory);
+  uint64_t sequence = m_sequence + 1;
+  uint8_t* base = m_memory + HEADER_SIZE + (sequence % COPIES)*header->stride;
+  auto copy = reinterpret_cast<RetainedCopy*>(base);
+  // the other copy stays valid until this one is complete
+  copy->sequence = 0;
+  std::memcpy(copy + 1, m_scratch.data(), m_scratch.size());
+  copy->version = m_state->version();
+  copy->size = m_state->size();
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  copy->timestamp = int64_t(now.tv_sec)*1000000000 + now.tv_nsec;
+  copy->sequence = sequence;
+  copy->checksum = checksum(*copy, copy + 1);
+  size_t page = sysconf(_SC_PAGESIZE);
+  uint8_t* first = m_memory + (base - m_memory)/page*page;
+  msync(first, base + header->stride - first, MS_SYNC);
+  m_sequence = sequence;
+  m_flushes.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void StatePersistence::close(){
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_wake.notify_all();
+  if(m_thread.joinable())
+    m_thread.join();
+  if(!m_memory)
+    return;
+  // the state of the last tick
+  flush();
+  munmap(m_memory, m_size);
+  m_memory = nullptr;
+  m_size = 0;
+  m_state = nullptr;
+}
+}
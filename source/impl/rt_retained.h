@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "rt_triple_buffer.h"
+
+namespace Example{
+  // Access of RTApplication to the retained state of the user code
+  class IRetainedState
+  {
+    public:
+      virtual ~IRetainedState() = default;
+      virtual uint32_t version() const = 0;
+      virtual uint32_t size() const = 0;
+      // Non-RT, before the first tick: takes over a stored state, false if it cannot be used
+      virtual bool restore(const void* data, uint32_t size, uint32_t version) = 0;
+      // RT, at the end of the tick
+      virtual void capture() = 0;
+      // Non-RT: copies the newest captured state, false if nothing was captured since the last call
+      virtual bool snapshot(void* data) = 0;
+  };
+
+  // State of the user code that survives a restart (axis references, counters, integrators, ...), a fixed
+  // layout T with a static VERSION. The tick works on get() and captures a copy at its end; non-RT code takes
+  // the newest copy through a triple buffer and stores it, see StatePersistence. A stored state of another
+  // VERSION or size is passed to T::migrate(data, size, version) if T has it, otherwise it is not restored.
+  template<typename T>
+  class RetainedState:public IRetainedState
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "retained state is copied between the buffers and the file");
+
+    public:
+      uint32_t version() const override { return T::VERSION; }
+      uint32_t size() const override { return sizeof(T); }
+      bool restore(const void* data, uint32_t size, uint32_t version) override{
+        if(version == T::VERSION && size == sizeof(T)){
+          std::memcpy(&m_live, data, sizeof(T));
+          return true;
+        }
+        if constexpr(requires(T& value){ { value.migrate(data, size, version) } -> std::convertible_to<bool>; })
+          return m_live.migrate(data, size, version);
+        return false;
+      }
+      void capture() override{
+        m_buffer.back() = m_live;
+        m_buffer.publish();
+      }
+      bool snapshot(void* data) override{
+        if(!m_buffer.update())
+          return false;
+        std::memcpy(data, &m_buffer.front(), sizeof(T));
+        return true;
+      }
+
+      // RT
+      T& get() { return m_live; }
+
+    private:
+      T m_live{};
+      TripleBuffer<T> m_buffer;
+  };
+
+  // Keeps a retained state in a memory-mapped file. The file holds two copies that are written alternately,
+  // each with a sequence number and a checksum, so a copy torn by a crash or power loss is detected and the
+  // other one is used. open() restores the newest valid copy; a thread flushes the captured state at a
+  // fixed interval and close() flushes it a last time.
+  class StatePersistence
+  {
+    public:
+      ~StatePersistence();
+
+      // Non-RT. True if a stored state was restored; otherwise error tells why, the file is used anyway
+      bool open(const std::string& path, IRetainedState& state, std::string& error);
+      void start(uint32_t intervalMs);
+      void close();
+      bool isOpen() const { return m_memory != nullptr; }
+      uint64_t flushes() const { return m_flushes.load(std::memory_order_relaxed); }
+
+    private:
+      bool flush();
+      void run(uint32_t intervalMs);
+
+      IRetainedState* m_state = nullptr;
+      uint8_t* m_memory = nullptr;
+      size_t m_size = 0;
+      uint64_t m_sequence = 0;
+      std::vector<uint8_t> m_scratch;
+      std::mutex m_mutex;
+      std::condition_variable m_wake;
+      bool m_running = false;
+      std::thread m_thread;
+      std::atomic<uint64_t> m_flushes{0};
+  };
+}
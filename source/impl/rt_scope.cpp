@@ -0,0 +1,141 @@
+#include "rt_scope.h"
+
+namespace Example{
+bool Oscilloscope::addChannel(const std::string& name, ScopeImage image, const SignalRef& signal){
+  if(m_count == SCOPE_MAX_CHANNELS)
+    return false;
+  m_channels[m_count++] = Channel{name, image, signal};
+  allocate();
+  return true;
+}
+
+void Oscilloscope::setTrigger(ScopeImage image, const SignalRef& signal, ScopeTrigger trigger, double threshold, uint32_t mask){
+  m_triggerImage = image;
+  m_triggerSignal = signal;
+  m_trigger = trigger;
+  m_threshold = threshold;
+  m_mask = mask;
+}
+
+void Oscilloscope::setDepth(uint32_t preTrigger, uint32_t postTrigger){
+  m_pre = preTrigger;
+  m_post = postTrigger ? postTrigger : 1;
+  m_depth = m_pre + m_post;
+  allocate();
+}
+
+void Oscilloscope::clear(){
+  m_state.store(ScopeState::Idle, std::memory_order_release);
+  m_count = 0;
+  m_buffer.clear();
+}
+
+void Oscilloscope::allocate(){
+  // the RT side only ever writes into this buffer, it is sized here once
+  m_buffer.assign(static_cast<size_t>(m_count)*m_depth, 0.0);
+}
+
+void Oscilloscope::arm(){
+  // the RT side resets the positions before it starts recording
+  m_state.store(ScopeState::ArmRequested, std::memory_order_release);
+}
+
+void Oscilloscope::disarm(){
+  m_state.store(ScopeState::Idle, std::memory_order_release);
+}
+
+void Oscilloscope::restart(){
+  m_position = 0;
+  m_filled = 0;
+  m_remaining = m_post;
+  m_lastLevel = true; // a condition already true on arming is not an edge
+}
+
+void Oscilloscope::sample(ScopeImage image, const uint8_t* data){
+  if(!isArmed(m_state.load(std::memory_order_relaxed)))
+    return;
+
+  double* column = m_buffer.data() + m_position;
+  for(uint32_t channel = 0; channel < m_count; channel++){
+    if(m_channels[channel].image == image)
+      column[static_cast<size_t>(channel)*m_depth] = m_channels[channel].signal.read(data);
+  }
+
+  if(image == m_triggerImage){
+    double value = m_triggerSignal.read(data);
+    switch(m_trigger)
+    {
+      case ScopeTrigger::RisingEdge:
+      case ScopeTrigger::Above:
+        m_triggerLevel = value >= m_threshold;
+        break;
+      case ScopeTrigger::FallingEdge:
+      case ScopeTrigger::Below:
+        m_triggerLevel = value < m_threshold;
+        break;
+      case ScopeTrigger::BitSet:
+        m_triggerLevel = (static_cast<uint32_t>(static_cast<int64_t>(value)) & m_mask) != 0;
+        break;
+      case ScopeTrigger::BitCleared:
+        m_triggerLevel = (static_cast<uint32_t>(static_cast<int64_t>(value)) & m_mask) == 0;
+        break;
+    }
+  }
+}
+
+bool Oscilloscope::advance(){
+  auto state = m_state.load(std::memory_order_acquire);
+  if(state == ScopeState::ArmRequested){
+    restart();
+    m_state.compare_exchange_strong(state, ScopeState::Armed, std::memory_order_acq_rel);
+    return false;
+  }
+  if(!isArmed(state) || m_depth == 0 || m_count == 0)
+    return false;
+
+  m_position = m_position + 1 == m_depth ? 0 : m_position + 1;
+
+  if(state == ScopeState::Armed){
+    bool level = m_triggerLevel;
+    bool edge = level && !m_lastLevel;
+    m_lastLevel = level;
+    if(m_filled < m_pre){
+      m_filled++;
+      return false;
+    }
+    bool fire = (m_trigger == ScopeTrigger::Above || m_trigger == ScopeTrigger::Below) ? level : edge;
+    if(fire){
+      // the triggering sample is the first post-trigger sample
+      m_remaining = m_post - 1;
+      if(m_remaining == 0)
+        return m_state.compare_exchange_strong(state, ScopeState::Complete, std::memory_order_acq_rel);
+      m_state.compare_exchange_strong(state, ScopeState::Triggered, std::memory_order_acq_rel);
+    }
+  }
+  else if(--m_remaining == 0){
+    return m_state.compare_exchange_strong(state, ScopeState::Complete, std::memory_order_acq_rel);
+  }
+  return false;
+}
+
+double Oscilloscope::value(uint32_t channel, uint32_t index) const{
+  // once complete, the oldest sample is at the write position
+  uint32_t slot = m_position + index;
+  if(slot >= m_depth)
+    slot -= m_depth;
+  return m_buffer[static_cast<size_t>(channel)*m_depth + slot];
+}
+
+void Oscilloscope::exportCsv(std::ostream& out) const{
+  out << "sample";
+  for(uint32_t channel = 0; channel < m_count; channel++)
+    out << ";" << m_channels[channel].name;
+  out << "\n";
+  for(uint32_t index = 0; index < m_depth; index++){
+    out << static_cast<int64_t>(index) - static_cast<int64_t>(m_pre);
+    for(uint32_t channel = 0; channel < m_count; channel++)
+      out << ";" << value(channel, index);
+    out << "\n";
+  }
+}
+}
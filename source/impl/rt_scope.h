@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "rt_signal.h"
+
+namespace Example{
+  constexpr uint32_t SCOPE_MAX_CHANNELS = 16;
+
+  enum class ScopeImage : uint8_t
+  {
+    Input,
+    Output
+  };
+
+  enum class ScopeTrigger : uint8_t
+  {
+    RisingEdge,  // value crosses the threshold upwards
+    FallingEdge, // value crosses the threshold downwards
+    Above,       // value is at or above the threshold
+    Below,       // value is below the threshold
+    BitSet,      // a bit of the mask becomes set, e.g. a status word bit
+    BitCleared   // all bits of the mask become cleared
+  };
+
+  enum class ScopeState : uint8_t
+  {
+    Idle,
+    ArmRequested,
+    Armed,
+    Triggered,
+    Complete
+  };
+
+  // Triggered capture of bound AT/MDT values at tick resolution.
+  // While armed, the last N samples are kept in a rolling buffer; after the trigger M more samples
+  // are recorded and the capture is handed to non-RT code. Idle and completed captures cost one load per tick.
+  class Oscilloscope
+  {
+    public:
+      // Configuration, non-RT only and only while idle
+      bool addChannel(const std::string& name, ScopeImage image, const SignalRef& signal);
+      void setTrigger(ScopeImage image, const SignalRef& signal, ScopeTrigger trigger, double threshold, uint32_t mask = 0);
+      void setDepth(uint32_t preTrigger, uint32_t postTrigger);
+      void clear();
+
+      // Control, non-RT
+      void arm();
+      void disarm();
+      ScopeState state() const { return m_state.load(std::memory_order_acquire); }
+
+      // RT side: sample the channels of one image while it is accessible, then advance once per tick.
+      // advance() returns true on the tick the capture completes.
+      void sample(ScopeImage image, const uint8_t* data);
+      bool advance();
+
+      // Access to a completed capture, non-RT
+      bool ready() const { return state() == ScopeState::Complete; }
+      uint32_t channelCount() const { return m_count; }
+      uint32_t length() const { return m_depth; }
+      uint32_t preTrigger() const { return m_pre; }
+      const std::string& channelName(uint32_t channel) const { return m_channels[channel].name; }
+      double value(uint32_t channel, uint32_t index) const;
+      void exportCsv(std::ostream& out) const;
+
+    private:
+      struct Channel
+      {
+        std::string name;
+        ScopeImage image;
+        SignalRef signal;
+      };
+
+      bool isArmed(ScopeState state) const { return state == ScopeState::Armed || state == ScopeState::Triggered; }
+      void allocate();
+      void restart();
+
+      Channel m_channels[SCOPE_MAX_CHANNELS];
+      uint32_t m_count = 0;
+      std::vector<double> m_buffer;
+      uint32_t m_pre = 100;
+      uint32_t m_post = 100;
+      uint32_t m_depth = 200;
+
+      ScopeImage m_triggerImage = ScopeImage::Input;
+      SignalRef m_triggerSignal;
+      ScopeTrigger m_trigger = ScopeTrigger::RisingEdge;
+      double m_threshold = 0.0;
+      uint32_t m_mask = 0;
+      bool m_triggerLevel = false;
+      bool m_lastLevel = true;
+
+      uint32_t m_position = 0;
+      uint32_t m_filled = 0;
+      uint32_t m_remaining = 0;
+      std::atomic<ScopeState> m_state{ScopeState::Idle};
+  };
+}
@@ -0,0 +1,148 @@
+#include "rt_sequencer.h"
+#include "rt_mpmc_queue.h"
+#include <atomic>
+#include <cstring>
+
+namespace Example{
+namespace {
+  // Fixed-size frames, all pages are touched when the library is loaded
+  class FramePool
+  {
+    public:
+      FramePool(){
+        std::memset(m_storage, 0, sizeof(m_storage));
+        for(uint32_t index = 0; index < Sequencer::FRAMES; index++)
+          m_free.push(index);
+      }
+
+      void* allocate(size_t size){
+        uint32_t index;
+        if(size > Sequencer::FRAME_SIZE || !m_free.pop(index))
+          return nullptr;
+        m_inUse.fetch_add(1, std::memory_order_relaxed);
+        return m_storage[index];
+      }
+
+      void release(void* frame){
+        auto index = static_cast<uint32_t>((static_cast<uint8_t*>(frame) - m_storage[0])/Sequencer::FRAME_SIZE);
+        m_inUse.fetch_sub(1, std::memory_order_relaxed);
+        m_free.push(index);
+      }
+
+      size_t inUse() const { return m_inUse.load(std::memory_order_relaxed); }
+
+    private:
+      alignas(64) uint8_t m_storage[Sequencer::FRAMES][Sequencer::FRAME_SIZE];
+      MpmcQueue<uint32_t, Sequencer::FRAMES> m_free;
+      std::atomic<size_t> m_inUse{0};
+  };
+
+  FramePool frames;
+}
+
+void* SequencePromise::operator new(size_t size) noexcept{
+  return frames.allocate(size);
+}
+
+void SequencePromise::operator delete(void* frame) noexcept{
+  frames.release(frame);
+}
+
+Sequence& Sequence::operator=(Sequence&& other) noexcept{
+  if(this != &other){
+    if(m_handle)
+      m_handle.destroy();
+    m_handle = other.m_handle;
+    other.m_handle = nullptr;
+  }
+  return *this;
+}
+
+Sequence::~Sequence(){
+  if(m_handle)
+    m_handle.destroy();
+}
+
+SequenceHandle Sequence::release(){
+  SequenceHandle handle = m_handle;
+  m_handle = nullptr;
+  return handle;
+}
+
+std::coroutine_handle<> Sequence::await_suspend(SequenceHandle parent) noexcept{
+  auto& promise = parent.promise();
+  m_handle.promise().clock = promise.clock;
+  promise.wait = SequenceWait::awaiting(m_handle);
+  // the child starts right away, as part of the caller's step
+  return m_handle;
+}
+
+bool Sequence::await_resume() const noexcept{
+  return m_handle && m_handle.promise().result;
+}
+
+Sequencer::~Sequencer(){
+  clear();
+}
+
+bool Sequencer::start(Sequence sequence){
+  if(!sequence.valid() || m_sequences.full())
+    return false;
+  SequenceHandle handle = sequence.release();
+  handle.promise().clock = &m_now;
+  m_sequences.push_back(handle);
+  return true;
+}
+
+bool Sequencer::step(SequenceHandle handle){
+  if(handle.done())
+    return true;
+  auto& promise = handle.promise();
+  auto& wait = promise.wait;
+  switch(wait.kind)
+  {
+    case SequenceWait::Ready:
+      break;
+    case SequenceWait::Delay:
+      if(m_now < wait.deadline)
+        return false;
+      break;
+    case SequenceWait::Until:
+      if(!wait.check(wait.context)){
+        if(!wait.deadline || m_now < wait.deadline)
+          return false;
+        promise.timedOut = true;
+      }
+      break;
+    case SequenceWait::Child:
+      if(!step(wait.child))
+        return false;
+      break;
+  }
+  wait.kind = SequenceWait::Ready;
+  handle.resume();
+  return handle.done();
+}
+
+void Sequencer::tick(){
+  m_now++;
+  for(size_t index = 0; index < m_sequences.size();){
+    if(step(m_sequences[index])){
+      m_sequences[index].destroy();
+      m_sequences.swapErase(index);
+    }
+    else
+      index++;
+  }
+}
+
+void Sequencer::clear(){
+  for(auto& handle : m_sequences)
+    handle.destroy();
+  m_sequences.clear();
+}
+
+size_t Sequencer::framesInUse(){
+  return frames.inUse();
+}
+}
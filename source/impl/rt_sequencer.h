@@ -0,0 +1,174 @@
+#pragma once
+#include "rt_containers.h"
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+namespace Example{
+  // Multi-tick procedures (homing, enable sequences, tool changes) written as coroutines:
+  //
+  //   Example::Sequence home(){
+  //     co_await Example::until([]{ return ready(); });
+  //     if(!co_await Example::until([]{ return referenced(); }, 5000))
+  //       co_return false;                       // timed out after 5000 ticks
+  //     co_await Example::delay(100);
+  //     co_return true;
+  //   }
+  //   sequencer.start(home());
+  //
+  // Frames come from a preallocated pool, starting and running a sequence never allocates; a sequence whose
+  // frame does not fit or finds the pool empty is invalid and start() rejects it. The Sequencer resumes the
+  // sequences whose condition is met once per tick. A sequence can co_await another one, which then runs as
+  // a step of it and hands over its co_return value.
+  struct SequencePromise;
+  using SequenceHandle = std::coroutine_handle<SequencePromise>;
+
+  class Sequence
+  {
+    public:
+      using promise_type = SequencePromise;
+
+      Sequence() = default;
+      explicit Sequence(SequenceHandle handle) : m_handle(handle) {}
+      Sequence(Sequence&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+      Sequence& operator=(Sequence&& other) noexcept;
+      Sequence(const Sequence&) = delete;
+      Sequence& operator=(const Sequence&) = delete;
+      ~Sequence();
+
+      bool valid() const { return static_cast<bool>(m_handle); }
+      SequenceHandle release();
+
+      // co_await of a sequence inside another one
+      bool await_ready() const noexcept { return !m_handle; }
+      std::coroutine_handle<> await_suspend(SequenceHandle parent) noexcept;
+      bool await_resume() const noexcept;
+
+    private:
+      SequenceHandle m_handle;
+  };
+
+  // What a suspended sequence waits for, evaluated by the Sequencer every tick
+  struct SequenceWait
+  {
+    enum Kind : uint8_t
+    {
+      Ready,
+      Delay,
+      Until,
+      Child
+    };
+    Kind kind = Ready;
+    uint64_t deadline = 0;            // tick, 0: no timeout for Until
+    bool (*check)(void*) = nullptr;   // Until
+    void* context = nullptr;
+    SequenceHandle child;
+
+    static SequenceWait delay(uint64_t deadline){
+      SequenceWait wait;
+      wait.kind = Delay;
+      wait.deadline = deadline;
+      return wait;
+    }
+    static SequenceWait until(bool (*check)(void*), void* context, uint64_t deadline){
+      SequenceWait wait;
+      wait.kind = Until;
+      wait.deadline = deadline;
+      wait.check = check;
+      wait.context = context;
+      return wait;
+    }
+    static SequenceWait awaiting(SequenceHandle child){
+      SequenceWait wait;
+      wait.kind = Child;
+      wait.child = child;
+      return wait;
+    }
+  };
+
+  struct SequencePromise
+  {
+    SequenceWait wait;
+    const uint64_t* clock = nullptr;  // tick counter of the Sequencer
+    bool timedOut = false;
+    bool result = false;
+
+    static void* operator new(size_t size) noexcept;
+    static void operator delete(void* frame) noexcept;
+    static Sequence get_return_object_on_allocation_failure() noexcept { return Sequence(); }
+
+    Sequence get_return_object() noexcept { return Sequence(SequenceHandle::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_value(bool value) noexcept { result = value; }
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    uint64_t now() const { return clock ? *clock : 0; }
+  };
+
+  struct DelayAwaiter
+  {
+    uint64_t ticks;
+
+    bool await_ready() const noexcept { return ticks == 0; }
+    void await_suspend(SequenceHandle handle) noexcept{
+      auto& promise = handle.promise();
+      promise.wait = SequenceWait::delay(promise.now() + ticks);
+    }
+    void await_resume() const noexcept {}
+  };
+
+  template<typename Predicate>
+  struct UntilAwaiter
+  {
+    Predicate predicate;
+    uint64_t timeout;
+    SequencePromise* promise = nullptr;
+
+    bool await_ready(){ return predicate(); }
+    void await_suspend(SequenceHandle handle) noexcept{
+      promise = &handle.promise();
+      promise->timedOut = false;
+      promise->wait = SequenceWait::until([](void* context){ return static_cast<bool>((*static_cast<Predicate*>(context))()); },
+                                          &predicate, timeout ? promise->now() + timeout : 0);
+    }
+    // false if the timeout expired first
+    bool await_resume() const noexcept { return !promise || !promise->timedOut; }
+  };
+
+  // Resumes at the next tick
+  inline DelayAwaiter nextTick() { return DelayAwaiter{1}; }
+  inline DelayAwaiter delay(uint64_t ticks) { return DelayAwaiter{ticks}; }
+  // Resumes once predicate() holds, checked every tick; with a timeout in ticks it returns false when it expired
+  template<typename Predicate>
+  UntilAwaiter<Predicate> until(Predicate predicate, uint64_t timeout = 0) { return UntilAwaiter<Predicate>{predicate, timeout}; }
+
+  class Sequencer
+  {
+    public:
+      static constexpr size_t CAPACITY = 512;
+
+      ~Sequencer();
+
+      // RT-safe; false if the sequence is invalid or all places are taken, the sequence is dropped then
+      bool start(Sequence sequence);
+      // Resumes every sequence whose condition is met, finished sequences release their frames
+      void tick();
+      // Destroys all sequences
+      void clear();
+      size_t size() const { return m_sequences.size(); }
+      uint64_t ticks() const { return m_now; }
+
+      // Frames of all sequencers
+      static constexpr size_t FRAME_SIZE = 1024;
+      static constexpr size_t FRAMES = 1024;
+      static size_t framesInUse();
+
+    private:
+      bool step(SequenceHandle handle);
+
+      uint64_t m_now = 0;
+      StaticVector<SequenceHandle, CAPACITY> m_sequences;
+  };
+}
@@ -0,0 +1,58 @@
+#include "rt_shadow.h"
+#include <cstring>
+#include <ctime>
+
+namespace Example{
+uint64_t ShadowRunner::now(){
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return uint64_t(time.tv_sec)*1000000000 + time.tv_nsec;
+}
+
+void ShadowRunner::watch(const std::string& path, ProcessImage& image){
+  // the output image keeps its size while bound, the shadow is sized once before a candidate can run
+  m_outputs.assign(image.outputSize(), 0);
+  resetWindow();
+  m_candidate.watch(path, image);
+}
+
+void ShadowRunner::unload(){
+  m_candidate.unload();
+  m_outputs.clear();
+}
+
+void ShadowRunner::resetWindow(){
+  m_window = ShadowReport{};
+  m_window.firstDivergence = -1;
+}
+
+bool ShadowRunner::record(const uint8_t* outData, uint64_t activeNs, uint64_t candidateNs){
+  size_t size = m_outputs.size();
+  if(std::memcmp(outData, m_outputs.data(), size) != 0){
+    uint32_t bytes = 0;
+    for(size_t offset = 0; offset < size; offset++){
+      if(outData[offset] != m_outputs[offset]){
+        if(m_window.firstDivergence < 0)
+          m_window.firstDivergence = static_cast<int32_t>(offset);
+        bytes++;
+      }
+    }
+    m_window.divergentTicks++;
+    m_window.divergentBytes += bytes;
+  }
+  m_window.ticks++;
+  m_window.activeSumNs += activeNs;
+  m_window.activeMaxNs = std::max(m_window.activeMaxNs, activeNs);
+  m_window.candidateSumNs += candidateNs;
+  m_window.candidateMaxNs = std::max(m_window.candidateMaxNs, candidateNs);
+  m_activeNs = 0;
+  m_candidateNs = 0;
+  if(m_window.ticks < m_windowTicks)
+    return false;
+  m_window.sequence = m_sequence++;
+  if(!m_reports.push(m_window))
+    m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  resetWindow();
+  return true;
+}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "rt_process_image.h"
+#include "rt_spsc_queue.h"
+#include "rt_user_module.h"
+
+namespace Example{
+  // Comparison of a candidate module with the active logic over one window of ticks
+  struct ShadowReport
+  {
+    uint64_t sequence;
+    uint32_t ticks;
+    uint32_t divergentTicks;  // ticks whose outputs differed
+    uint64_t divergentBytes;
+    int32_t firstDivergence;  // byte offset in the output image of the first difference, -1 if none
+    uint64_t activeSumNs;     // AT + MDT of the active logic
+    uint64_t activeMaxNs;
+    uint64_t candidateSumNs;  // AT + MDT of the candidate
+    uint64_t candidateMaxNs;
+  };
+
+  // Runs a candidate logic module next to the active logic without letting it drive outputs.
+  // The candidate gets the same inputs; its MDT writes into a shadow output image that starts every tick
+  // as a copy of the outputs before the active MDT and is discarded after the comparison. Both
+  // implementations are timed, the differences and timings of every window are handed to non-RT code.
+  class ShadowRunner
+  {
+    public:
+      // Non-RT; the candidate is loaded from path whenever the file changes
+      void watch(const std::string& path, ProcessImage& image);
+      void unload();
+      void setWindow(uint32_t ticks) { m_windowTicks = ticks ? ticks : 1; }
+      std::string candidateName() const { return m_candidate.activeName(); }
+      bool poll(ShadowReport& report) { return m_reports.pop(report); }
+      uint64_t droppedReports() const { return m_dropped.load(std::memory_order_relaxed); }
+
+      // RT side. Without a candidate both only run the active logic.
+      // A new candidate starts from the state of the active module, if the active logic is one
+      void switchModule(const UserModuleHost& active) { m_candidate.switchModule(&active); }
+      bool active() const { return m_candidate.active(); }
+      template<typename Logic>
+      void AT(const uint8_t* inData, Logic&& logic){
+        if(!m_candidate.active()){
+          logic(inData);
+          return;
+        }
+        uint64_t begin = now();
+        logic(inData);
+        uint64_t middle = now();
+        m_candidate.AT(inData);
+        uint64_t end = now();
+        m_activeNs = middle - begin;
+        m_candidateNs = end - middle;
+      }
+      // true when a window is complete and a report can be polled
+      template<typename Logic>
+      bool MDT(uint8_t* outData, Logic&& logic){
+        if(!m_candidate.active()){
+          logic(outData);
+          return false;
+        }
+        std::copy(outData, outData + m_outputs.size(), m_outputs.begin());
+        uint64_t begin = now();
+        logic(outData);
+        uint64_t middle = now();
+        m_candidate.MDT(m_outputs.data());
+        uint64_t end = now();
+        return record(outData, m_activeNs + (middle - begin), m_candidateNs + (end - middle));
+      }
+
+    private:
+      static uint64_t now();
+      bool record(const uint8_t* outData, uint64_t activeNs, uint64_t candidateNs);
+      void resetWindow();
+
+      UserModuleHost m_candidate;
+      std::vector<uint8_t> m_outputs; // shadow output image
+      uint64_t m_activeNs = 0;
+      uint64_t m_candidateNs = 0;
+      uint32_t m_windowTicks = 10000;
+      uint64_t m_sequence = 0;
+      std::atomic<uint64_t> m_dropped{0}; // RT only writer
+      ShadowReport m_window{};
+      SpscQueue<ShadowReport, 16> m_reports;
+  };
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+namespace Example{
+  enum class SignalType : uint8_t
+  {
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64
+  };
+
+  // Reference to a typed value either inside a process image (offset relative to the image
+  // pointer handed out by beginAccess) or at a fixed address such as a variable of the user code.
+  struct SignalRef
+  {
+    const uint8_t* address = nullptr;
+    uint32_t offset = 0;
+    SignalType type = SignalType::Int32;
+
+    static SignalRef image(uint32_t bitOffset, SignalType type){
+      return SignalRef{nullptr, bitOffset/8, type};
+    }
+    template<typename T>
+    static SignalRef variable(const T* value, SignalType type){
+      return SignalRef{reinterpret_cast<const uint8_t*>(value), 0, type};
+    }
+
+    double read(const uint8_t* image) const{
+      const uint8_t* p = (address ? address : image) + offset;
+      switch(type)
+      {
+        case SignalType::Int8: return load<int8_t>(p);
+        case SignalType::UInt8: return load<uint8_t>(p);
+        case SignalType::Int16: return load<int16_t>(p);
+        case SignalType::UInt16: return load<uint16_t>(p);
+        case SignalType::Int32: return load<int32_t>(p);
+        case SignalType::UInt32: return load<uint32_t>(p);
+        case SignalType::Float32: return load<float>(p);
+        case SignalType::Float64: return load<double>(p);
+      }
+      return 0.0;
+    }
+
+    private:
+      template<typename T>
+      static double load(const uint8_t* p){
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return static_cast<double>(value);
+      }
+  };
+}
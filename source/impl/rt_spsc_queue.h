@@ -0,0 +1,44 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Example{
+  // Bounded single-producer/single-consumer ring used to hand data between the RT tick and non-RT code.
+  // Neither side ever blocks: push fails when the ring is full, pop fails when it is empty.
+  template<typename T, size_t N>
+  class SpscQueue
+  {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+    public:
+      bool push(const T& item){
+        auto head = m_head.load(std::memory_order_relaxed);
+        if(head - m_tail.load(std::memory_order_acquire) == N)
+          return false;
+        m_items[head & (N - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool pop(T& item){
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if(tail == m_head.load(std::memory_order_acquire))
+          return false;
+        item = m_items[tail & (N - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool empty() const{
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+      }
+
+      static constexpr size_t capacity(){ return N; }
+
+    private:
+      alignas(64) std::atomic<size_t> m_head{0};
+      alignas(64) std::atomic<size_t> m_tail{0};
+      alignas(64) std::array<T, N> m_items{};
+  };
+}
@@ -0,0 +1,87 @@
+#include "rt_telemetry.h"
+#include <cmath>
+#include <limits>
+
+namespace Example{
+bool TelemetryAggregator::addChannel(const std::string& name, const SignalRef& signal){
+  if(m_count == TELEMETRY_MAX_CHANNELS)
+    return false;
+  m_signals[m_count++] = signal;
+  m_names.push_back(name);
+  m_blocks = (m_count + LANES - 1)/LANES;
+  resetWindow();
+  return true;
+}
+
+void TelemetryAggregator::setWindow(uint32_t ticks){
+  m_windowTicks = ticks ? ticks : 1;
+  resetWindow();
+}
+
+void TelemetryAggregator::clear(){
+  m_count = 0;
+  m_blocks = 0;
+  m_names.clear();
+  m_sequence = 0;
+  m_dropped.store(0, std::memory_order_relaxed);
+  TelemetryWindow window;
+  while(m_windows.pop(window)){}
+  resetWindow();
+}
+
+bool TelemetryAggregator::update(const uint8_t* image){
+  if(m_count == 0)
+    return false;
+
+  // gather the signals into the lanes, unused lanes stay zero
+  for(uint32_t channel = 0; channel < m_count; channel++){
+    m_value[channel/LANES][channel%LANES] = m_signals[channel].read(image);
+  }
+
+  for(uint32_t block = 0; block < m_blocks; block++){
+    Lanes value = m_value[block];
+    m_min[block] = value < m_min[block] ? value : m_min[block];
+    m_max[block] = value > m_max[block] ? value : m_max[block];
+    m_sum[block] += value;
+    m_sumSq[block] += value*value;
+  }
+
+  if(++m_samples != m_windowTicks)
+    return false;
+  publish();
+  return true;
+}
+
+void TelemetryAggregator::publish(){
+  m_window.sequence = m_sequence++;
+  m_window.samples = m_samples;
+  m_window.channels = m_count;
+  const double scale = 1.0/m_samples;
+  for(uint32_t block = 0; block < m_blocks; block++){
+    Lanes mean = m_sum[block]*scale;
+    Lanes meanSq = m_sumSq[block]*scale;
+    for(uint32_t lane = 0; lane < LANES; lane++){
+      uint32_t channel = block*LANES + lane;
+      m_window.min[channel] = m_min[block][lane];
+      m_window.max[channel] = m_max[block][lane];
+      m_window.mean[channel] = mean[lane];
+      m_window.rms[channel] = std::sqrt(meanSq[lane]);
+    }
+  }
+  if(!m_windows.push(m_window))
+    m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  resetWindow();
+}
+
+void TelemetryAggregator::resetWindow(){
+  const double inf = std::numeric_limits<double>::infinity();
+  for(uint32_t block = 0; block < BLOCKS; block++){
+    m_value[block] = Lanes{};
+    m_min[block] = Lanes{} + inf;
+    m_max[block] = Lanes{} - inf;
+    m_sum[block] = Lanes{};
+    m_sumSq[block] = Lanes{};
+  }
+  m_samples = 0;
+}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+#include "rt_signal.h"
+#include "rt_spsc_queue.h"
+
+namespace Example{
+  constexpr uint32_t TELEMETRY_MAX_CHANNELS = 32;
+
+  // Statistics of one completed window, handed to non-RT code
+  struct TelemetryWindow
+  {
+    uint64_t sequence;
+    uint32_t samples;
+    uint32_t channels;
+    double min[TELEMETRY_MAX_CHANNELS];
+    double max[TELEMETRY_MAX_CHANNELS];
+    double mean[TELEMETRY_MAX_CHANNELS];
+    double rms[TELEMETRY_MAX_CHANNELS];
+  };
+
+  // Running min/max/mean/RMS over a window of ticks for a set of configured signals.
+  // Channels are stored structure-of-arrays in vector lanes so one tick updates four channels per operation.
+  class TelemetryAggregator
+  {
+    public:
+      // Configuration, non-RT only
+      bool addChannel(const std::string& name, const SignalRef& signal);
+      void setWindow(uint32_t ticks);
+      void clear();
+      uint32_t channelCount() const { return m_count; }
+      const std::string& channelName(uint32_t channel) const { return m_names[channel]; }
+
+      // Called once per tick while the input image is accessible; true when it completed a window
+      bool update(const uint8_t* image);
+
+      // Non-RT consumer side
+      bool poll(TelemetryWindow& window) { return m_windows.pop(window); }
+      uint64_t droppedWindows() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    private:
+      typedef double Lanes __attribute__((vector_size(32)));
+      static constexpr uint32_t LANES = sizeof(Lanes)/sizeof(double);
+      static constexpr uint32_t BLOCKS = TELEMETRY_MAX_CHANNELS/LANES;
+
+      void resetWindow();
+      void publish();
+
+      SignalRef m_signals[TELEMETRY_MAX_CHANNELS];
+      std::vector<std::string> m_names;
+      uint32_t m_count = 0;
+      uint32_t m_blocks = 0;
+      uint32_t m_windowTicks = 100;
+      uint32_t m_samples = 0;
+      uint64_t m_sequence = 0;
+      std::atomic<uint64_t> m_dropped{0}; // written by the tick only, read by non-RT code
+
+      Lanes m_value[BLOCKS];
+      Lanes m_min[BLOCKS];
+      Lanes m_max[BLOCKS];
+      Lanes m_sum[BLOCKS];
+      Lanes m_sumSq[BLOCKS];
+
+      TelemetryWindow m_window;
+      SpscQueue<TelemetryWindow, 16> m_windows;
+  };
+}
@@ -0,0 +1,211 @@
+#include "rt_timeline.h"
+#include "rt_spsc_queue.h"
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace Example{
+namespace {
+  struct Ring
+  {
+    std::atomic<bool> claimed{false};
+    std::atomic<int> thread{0};
+    std::atomic<uint64_t> dropped{0};
+    SpscQueue<TimelineEvent, TIMELINE_EVENTS> events;
+  };
+
+  // allocated by the first start and never freed, a thread may still record while the timeline stops
+  std::atomic<Ring*> g_rings{nullptr};
+
+  // the ring of a thread is released when the thread ends, the writer still takes the events left in it
+  struct ThreadRing
+  {
+    Ring* ring = nullptr;
+    ~ThreadRing(){
+      if(ring)
+        ring->claimed.store(false, std::memory_order_release);
+    }
+  };
+  thread_local ThreadRing t_ring;
+
+  // writer side, guarded by g_mutex
+  std::mutex g_mutex;
+  std::condition_variable g_wake;
+  bool g_running = false;
+  std::thread g_thread;
+  std::FILE* g_file = nullptr;
+  bool g_first = true;
+  int g_named[TIMELINE_THREADS] = {};
+  uint64_t g_originStamp = 0;
+  uint64_t g_originNs = 0;
+  double g_stampsPerNs = 1.0;
+
+  uint64_t monotonicNs(){
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return uint64_t(time.tv_sec)*1000000000 + time.tv_nsec;
+  }
+
+  Ring* claim(){
+    Ring* rings = g_rings.load(std::memory_order_acquire);
+    if(!rings)
+      return nullptr;
+    for(size_t index = 0; index < TIMELINE_THREADS; index++){
+      bool free = false;
+      if(rings[index].claimed.load(std::memory_order_relaxed) ||
+         !rings[index].claimed.compare_exchange_strong(free, true, std::memory_order_acquire))
+        continue;
+      rings[index].thread.store(static_cast<int>(syscall(SYS_gettid)), std::memory_order_relaxed);
+      t_ring.ring = &rings[index];
+      return t_ring.ring;
+    }
+    return nullptr;
+  }
+
+  void separate(){
+    if(!g_first)
+      std::fputs(",\n", g_file);
+    g_first = false;
+  }
+
+  // JSON string with quotes, thread names are chosen by whoever starts the thread
+  void writeString(const char* text){
+    std::fputc('"', g_file);
+    for(const char* character = text; *character; character++){
+      unsigned char value = static_cast<unsigned char>(*character);
+      if(value == '"' || value == '\\')
+        std::fprintf(g_file, "\\%c", value);
+      else if(value < 0x20)
+        std::fprintf(g_file, "\\u%04x", value);
+      else
+        std::fputc(value, g_file);
+    }
+    std::fputc('"', g_file);
+  }
+
+  void nameThread(int thread){
+    std::ifstream file("/proc/self/task/" + std::to_string(thread) + "/comm");
+    std::string name;
+    if(!std::getline(file, name))
+      return;
+    separate();
+    std::fprintf(g_file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":", getpid(), thread);
+    writeString(name.c_str());
+    std::fputs("}}", g_file);
+  }
+
+  // microseconds of CLOCK_MONOTONIC, as the other processes of a trace use it
+  double microseconds(uint64_t stamp){
+    return (double(g_originNs) + double(int64_t(stamp - g_originStamp))/g_stampsPerNs)/1000.0;
+  }
+
+  void write(){
+    // the cycle counter is calibrated against the clock over the whole time since the start
+    uint64_t stamp = Timeline::stamp();
+    uint64_t elapsed = monotonicNs() - g_originNs;
+    if(elapsed > 1000000)
+      g_stampsPerNs = double(stamp - g_originStamp)/elapsed;
+    Ring* rings = g_rings.load(std::memory_order_acquire);
+    for(size_t index = 0; index < TIMELINE_THREADS; index++){
+      Ring& ring = rings[index];
+      if(ring.events.empty())
+        continue;
+      int thread = ring.thread.load(std::memory_order_relaxed);
+      if(g_named[index] != thread){
+        nameThread(thread);
+        g_named[index] = thread;
+      }
+      TimelineEvent event;
+      while(ring.events.pop(event)){
+        separate();
+        double begin = microseconds(event.begin);
+        std::fputs("{\"name\":", g_file);
+        writeString(event.name);
+        std::fprintf(g_file, ",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", getpid(), thread, begin, microseconds(event.end) - begin);
+      }
+    }
+    std::fflush(g_file);
+  }
+
+  void run(uint32_t intervalMs){
+    std::unique_lock<std::mutex> lock(g_mutex);
+    while(g_running){
+      g_wake.wait_for(lock, std::chrono::milliseconds(intervalMs), []{ return !g_running; });
+      write();
+    }
+  }
+}
+
+std::atomic<bool> Timeline::s_enabled{false};
+
+bool Timeline::start(const std::string& path, uint32_t intervalMs){
+  stop();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  Ring* rings = g_rings.load(std::memory_order_acquire);
+  if(!rings){
+    rings = new Ring[TIMELINE_THREADS];
+    g_rings.store(rings, std::memory_order_release);
+  }
+  // events left from an earlier run
+  TimelineEvent event;
+  for(size_t index = 0; index < TIMELINE_THREADS; index++){
+    while(rings[index].events.pop(event)){}
+    rings[index].dropped.store(0, std::memory_order_relaxed);
+    g_named[index] = 0;
+  }
+  g_file = std::fopen(path.c_str(), "w");
+  if(!g_file)
+    return false;
+  std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", g_file);
+  g_first = true;
+  separate();
+  std::fprintf(g_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"sdk-example-rt\"}}", getpid());
+  g_originNs = monotonicNs();
+  g_originStamp = stamp();
+#if !defined(__x86_64__) && !defined(__aarch64__)
+  g_stampsPerNs = 1.0;
+#endif
+  g_running = true;
+  g_thread = std::thread(run, intervalMs ? intervalMs : 1);
+  s_enabled.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void Timeline::stop(){
+  s_enabled.store(false, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_running = false;
+  }
+  g_wake.notify_all();
+  if(g_thread.joinable())
+    g_thread.join();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if(!g_file)
+    return;
+  write();
+  std::fputs("\n]}\n", g_file);
+  std::fclose(g_file);
+  g_file = nullptr;
+}
+
+uint64_t Timeline::dropped(){
+  Ring* rings = g_rings.load(std::memory_order_acquire);
+  uint64_t dropped = 0;
+  for(size_t index = 0; rings && index < TIMELINE_THREADS; index++)
+    dropped += rings[index].dropped.load(std::memory_order_relaxed);
+  return dropped;
+}
+
+void Timeline::record(const char* name, uint64_t begin, uint64_t end){
+  if(!enabled())
+    return;
+  Ring* ring = t_ring.ring ? t_ring.ring : claim();
+  if(ring && !ring->events.push(TimelineEvent{name, begin, end}))
+    ring->dropped.fetch_add(1, std::memory_order_relaxed);
+}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace Example{
+  // One section of a thread, in Timeline::stamp() units; the name is a string literal
+  struct TimelineEvent
+  {
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+  };
+
+  constexpr size_t TIMELINE_THREADS = 32;
+  constexpr size_t TIMELINE_EVENTS = 1u << 13; // per thread between two writes of the file
+
+  // Execution timeline of the process in the Chrome trace event format, which chrome://tracing and the
+  // Perfetto UI open. Every thread records its sections into a ring of its own, claimed with its first
+  // event and released when it ends, so recording takes neither a lock nor a system call. The timestamps
+  // are read from the cycle counter (TSC, CNTVCT) and converted when written. A thread of the timeline
+  // writes the rings to the file at a fixed interval. A section that does not fit into a full ring is
+  // dropped and counted.
+  class Timeline
+  {
+    public:
+      // Non-RT
+      static bool start(const std::string& path, uint32_t intervalMs = 100);
+      static void stop();
+      static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+      static uint64_t dropped();
+
+      // Any thread
+      static uint64_t stamp(){
+#if defined(__x86_64__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t value;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+        return value;
+#else
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return uint64_t(time.tv_sec)*1000000000 + time.tv_nsec;
+#endif
+      }
+      static void record(const char* name, uint64_t begin, uint64_t end);
+
+    private:
+      static std::atomic<bool> s_enabled;
+  };
+
+  // Records the section from its construction to the end of its scope, e.g. TimelineScope scope("AT");
+  class TimelineScope
+  {
+    public:
+      explicit TimelineScope(const char* name):m_name(name), m_begin(Timeline::enabled() ? Timeline::stamp() : 0){}
+      ~TimelineScope(){
+        if(m_begin)
+          Timeline::record(m_name, m_begin, Timeline::stamp());
+      }
+      TimelineScope(const TimelineScope&) = delete;
+      TimelineScope& operator=(const TimelineScope&) = delete;
+
+    private:
+      const char* m_name;
+      uint64_t m_begin;
+  };
+}
@@ -0,0 +1,91 @@
+#include "rt_timer_wheel.h"
+
+namespace Example{
+void TimerWheel::resize(size_t capacity){
+  clear();
+  m_free.clear();
+  m_nodes = std::vector<Node>(capacity);
+  for(auto& node : m_nodes)
+    m_free.pushBack(node);
+}
+
+void TimerWheel::clear(){
+  for(uint32_t level = 0; level < LEVELS; level++){
+    for(uint32_t slot = 0; slot < SLOTS; slot++){
+      while(Node* node = m_slots[level][slot].popFront())
+        release(*node);
+    }
+  }
+  m_pending = 0;
+  m_rejected = 0;
+}
+
+TimerHandle TimerWheel::schedule(uint64_t delayTicks, const TimedWrite& write){
+  if(delayTicks >= (uint64_t(1) << (LEVELS*SLOT_BITS)) || m_free.empty()){
+    m_rejected++;
+    return TimerHandle();
+  }
+  Node& node = *m_free.popFront();
+  node.due = m_now + delayTicks;
+  node.write = write;
+  node.scheduled = true;
+  insert(node);
+  m_pending++;
+  return TimerHandle{static_cast<uint32_t>(&node - m_nodes.data()), node.generation};
+}
+
+bool TimerWheel::cancel(TimerHandle handle){
+  if(handle.index >= m_nodes.size())
+    return false;
+  Node& node = m_nodes[handle.index];
+  // a handle from before resize() can match the generation of a free node
+  if(!node.scheduled || node.generation != handle.generation)
+    return false;
+  Slot::remove(node);
+  release(node);
+  m_pending--;
+  return true;
+}
+
+size_t TimerWheel::advance(uint8_t* outData){
+  // when the first level wraps, the coarser slots that start now are spread over the finer ones, the coarsest first
+  if((m_now & (SLOTS - 1)) == 0){
+    uint32_t top = 1;
+    while(top + 1 < LEVELS && ((m_now >> (top*SLOT_BITS)) & (SLOTS - 1)) == 0)
+      top++;
+    for(uint32_t level = top; level >= 1; level--)
+      cascade(level);
+  }
+  size_t applied = 0;
+  Slot& slot = m_slots[0][m_now & (SLOTS - 1)];
+  while(Node* node = slot.popFront()){
+    node->write.apply(outData);
+    release(*node);
+    applied++;
+  }
+  m_pending -= applied;
+  m_now++;
+  return applied;
+}
+
+void TimerWheel::insert(Node& node){
+  uint64_t delta = node.due - m_now;
+  uint32_t level = 0;
+  while(level + 1 < LEVELS && delta >= (uint64_t(1) << ((level + 1)*SLOT_BITS)))
+    level++;
+  m_slots[level][(node.due >> (level*SLOT_BITS)) & (SLOTS - 1)].pushBack(node);
+}
+
+void TimerWheel::cascade(uint32_t level){
+  m_cascade.splice(m_slots[level][(m_now >> (level*SLOT_BITS)) & (SLOTS - 1)]);
+  while(Node* node = m_cascade.popFront())
+    insert(*node);
+}
+
+void TimerWheel::release(Node& node){
+  // handles of the write become stale
+  node.scheduled = false;
+  node.generation++;
+  m_free.pushFront(node);
+}
+}
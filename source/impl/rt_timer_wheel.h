@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "rt_containers.h"
+#include "rt_process_image.h"
+
+namespace Example{
+  // Write of a bound output variable: the masked bits of up to 8 bytes at a byte offset of the output image
+  struct TimedWrite
+  {
+    uint32_t byteOffset = 0;
+    uint8_t size = 0;
+    uint64_t mask = 0;
+    uint64_t value = 0;
+
+    // The variable must be bound with image.output() so the value reaches the source
+    static TimedWrite set(const ImageVariable& variable, uint64_t value){
+      TimedWrite write;
+      uint32_t shift = variable.bitOffset%8;
+      uint32_t bits = variable.bitSize < 64 ? variable.bitSize : 64;
+      write.byteOffset = variable.byteOffset();
+      write.size = static_cast<uint8_t>(shift + bits > 64 ? 8 : (shift + bits + 7)/8);
+      write.mask = (bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1) << shift;
+      write.value = value << shift;
+      return write;
+    }
+
+    void apply(uint8_t* image) const{
+      uint64_t current = 0;
+      std::memcpy(&current, image + byteOffset, size);
+      current = (current & ~mask) | (value & mask);
+      std::memcpy(image + byteOffset, &current, size);
+    }
+  };
+
+  // Identifies a scheduled write for cancel(); a handle of a write that expired or was cancelled is stale
+  struct TimerHandle
+  {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+    bool valid() const { return index != UINT32_MAX; }
+  };
+
+  // Output writes at future ticks, e.g. a digital output pulsed for 37 ticks or a valve opened 20 ms after an
+  // input edge. Four levels of 256 slots cover 2^32 ticks: a write due within 256 ticks waits in a slot of
+  // the first level, later ones in the coarser levels, and a slot of a coarser level is spread over the
+  // finer ones when the time reaches it. Scheduling and cancelling take constant time, a tick takes the
+  // time of the writes that expire in it plus these redistributions, which each write passes at most three
+  // times. The nodes come from a pool that is sized while binding; the pool is a free ring, so none of it
+  // allocates or scans.
+  class TimerWheel
+  {
+    public:
+      // Non-RT, drops all scheduled writes
+      void resize(size_t capacity);
+      void clear();
+      size_t capacity() const { return m_nodes.size(); }
+
+      // RT; applied in the tick delayTicks from now, 0 = in this tick. Invalid if the pool is empty or the delay too long
+      TimerHandle schedule(uint64_t delayTicks, const TimedWrite& write);
+      // False if the write already expired or was cancelled
+      bool cancel(TimerHandle handle);
+      size_t pending() const { return m_pending; }
+      uint64_t rejected() const { return m_rejected; }
+      uint64_t now() const { return m_now; }
+
+      // RT, once per tick after the MDT: applies the writes due in this tick to the output image
+      size_t advance(uint8_t* outData);
+
+    private:
+      static constexpr uint32_t LEVELS = 4;
+      static constexpr uint32_t SLOT_BITS = 8;
+      static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+
+      struct Node
+      {
+        RingLink link;
+        uint64_t due = 0;
+        uint32_t generation = 0;
+        bool scheduled = false; // in a slot, not in the free ring
+        TimedWrite write;
+      };
+      typedef IntrusiveRing<Node, &Node::link> Slot;
+
+      void insert(Node& node);
+      void cascade(uint32_t level);
+      void release(Node& node);
+
+      std::vector<Node> m_nodes;
+      Slot m_free;
+      Slot m_slots[LEVELS][SLOTS];
+      Slot m_cascade; // scratch of cascade()
+      uint64_t m_now = 0;
+      size_t m_pending = 0;
+      uint64_t m_rejected = 0;
+  };
+}
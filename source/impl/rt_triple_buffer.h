@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace Example{
+  // Hands complete values from one non-RT writer to the RT tick. The writer fills its back buffer and
+  // publishes it, the reader takes the newest published buffer; each side swaps its own buffer with the
+  // shared one in one atomic exchange, so neither waits and the reader never sees a partly written value.
+  template<typename T>
+  class TripleBuffer
+  {
+    public:
+      // Writer side
+      T& back() { return m_buffers[m_back]; }
+      void publish(){
+        m_back = m_shared.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+      }
+
+      // Reader side, true if a newer value was taken
+      bool update(){
+        if(!(m_shared.load(std::memory_order_relaxed) & FRESH))
+          return false;
+        m_front = m_shared.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+        return true;
+      }
+      const T& front() const { return m_buffers[m_front]; }
+
+    private:
+      static constexpr uint8_t INDEX = 0x03;
+      static constexpr uint8_t FRESH = 0x04;
+
+      T m_buffers[3]{};
+      alignas(64) uint8_t m_back = 0;               // writer
+      alignas(64) std::atomic<uint8_t> m_shared{1};
+      alignas(64) uint8_t m_front = 2;              // reader
+  };
+}
@@ -0,0 +1,171 @@
+#include "rt_user_module.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace Example{
+namespace {
+  constexpr size_t STATE_ALIGNMENT = 64;
+  // ticks run on copies of state and images before the switch, to fault in code and data
+  constexpr int WARMUP_TICKS = 100;
+  // how long load() waits for the tick to take over before it leaves the cleanup to the next call
+  constexpr auto SWITCH_TIMEOUT = std::chrono::seconds(1);
+
+  int lookupInput(void* context, const char* name, uint32_t* bitOffset, uint32_t* bitSize){
+    auto variable = static_cast<ProcessImage*>(context)->input(name);
+    if(!variable)
+      return -1;
+    *bitOffset = variable->bitOffset;
+    *bitSize = variable->bitSize;
+    return 0;
+  }
+
+  int lookupOutput(void* context, const char* name, uint32_t* bitOffset, uint32_t* bitSize){
+    auto variable = static_cast<ProcessImage*>(context)->output(name);
+    if(!variable)
+      return -1;
+    *bitOffset = variable->bitOffset;
+    *bitSize = variable->bitSize;
+    return 0;
+  }
+
+  void* allocateState(uint32_t size){
+    size_t bytes = (std::max<size_t>(size, 1) + STATE_ALIGNMENT - 1)/STATE_ALIGNMENT*STATE_ALIGNMENT;
+    void* state = std::aligned_alloc(STATE_ALIGNMENT, bytes);
+    if(state)
+      std::memset(state, 0, bytes);
+    return state;
+  }
+}
+
+UserModuleHost::~UserModuleHost(){
+  unload();
+}
+
+void UserModuleHost::release(Module* module){
+  if(!module)
+    return;
+  std::free(module->state);
+  if(module->handle)
+    dlclose(module->handle);
+  delete module;
+}
+
+void UserModuleHost::reclaim(){
+  release(m_retired.exchange(nullptr, std::memory_order_acq_rel));
+}
+
+bool UserModuleHost::load(const std::string& path, ProcessImage& image, std::string& error){
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  reclaim();
+
+  // dlopen hands out the already loaded object for a known path, so every version is opened from a private copy
+  std::error_code failure;
+  auto copy = std::filesystem::temp_directory_path(failure) /
+              ("example-module-" + std::to_string(getpid()) + "-" + std::to_string(++m_generation) + ".so");
+  if(!std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, failure)){
+    error = "cannot copy " + path + ": " + failure.message();
+    return false;
+  }
+  // all symbols are resolved now, there is no lazy binding in the tick
+  void* handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+  std::filesystem::remove(copy, failure);
+  if(!handle){
+    error = dlerror();
+    return false;
+  }
+
+  auto module = new Module();
+  module->handle = handle;
+  auto entry = reinterpret_cast<ExampleModuleEntry>(dlsym(handle, EXAMPLE_MODULE_ENTRY));
+  module->api = entry ? entry() : nullptr;
+  const ExampleModule* api = module->api;
+  if(!api || api->abiVersion != EXAMPLE_MODULE_ABI_VERSION || !api->init || !api->AT || !api->MDT){
+    error = api ? "ABI version " + std::to_string(api->abiVersion) + " instead of " + std::to_string(EXAMPLE_MODULE_ABI_VERSION)
+                : std::string("no entry point " EXAMPLE_MODULE_ENTRY);
+    release(module);
+    return false;
+  }
+  module->name = api->name ? api->name : path;
+  module->state = allocateState(api->stateSize);
+  ExampleModuleImage variables{&image, lookupInput, lookupOutput};
+  if(!module->state || api->init(module->state, &variables) != 0){
+    error = module->name + ": init failed";
+    release(module);
+    return false;
+  }
+  // copy the variables the module bound from now on
+  image.finalize();
+
+  // warm up on copies, the tick's images and the state the module starts with stay untouched
+  {
+    void* scratch = allocateState(api->stateSize);
+    if(scratch){
+      std::memcpy(scratch, module->state, api->stateSize);
+      std::vector<uint8_t> inputs(image.inputSize());
+      std::vector<uint8_t> outputs(image.outputSize());
+      for(int tick = 0; tick < WARMUP_TICKS; tick++){
+        api->AT(scratch, inputs.data());
+        api->MDT(scratch, outputs.data());
+      }
+      std::free(scratch);
+    }
+  }
+
+  // a module that was loaded before but not taken over yet never ran and is dropped
+  release(m_pending.exchange(module, std::memory_order_acq_rel));
+  LOG_INFO("User module %s (state version %u) loaded, switching at the next tick", module->name.c_str(), api->stateVersion);
+
+  auto deadline = std::chrono::steady_clock::now() + SWITCH_TIMEOUT;
+  while(m_pending.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  reclaim();
+  return true;
+}
+
+void UserModuleHost::switchModule(const UserModuleHost* predecessor){
+  if(!m_pending.load(std::memory_order_relaxed))
+    return;
+  Module* next = m_pending.exchange(nullptr, std::memory_order_acq_rel);
+  if(!next)
+    return;
+  Module* previous = predecessor && predecessor->m_current ? predecessor->m_current : m_current;
+  if(previous && next->api->migrate_state)
+    next->api->migrate_state(next->state, previous->state, previous->api->stateVersion, previous->api->stateSize);
+  if(m_current)
+    m_retired.store(m_current, std::memory_order_release);
+  m_current = next;
+  m_running.store(next, std::memory_order_release);
+}
+
+std::string UserModuleHost::activeName() const{
+  Module* module = m_running.load(std::memory_order_acquire);
+  return module ? module->name : std::string();
+}
+
+void UserModuleHost::watch(const std::string& path, ProcessImage& image, uint32_t intervalMs){
+  m_watcher.start(path, [this, &image](const std::string& changed){
+    std::string error;
+    if(!load(changed, image, error))
+      LOG_ERROR("User module %s not loaded: %s", changed.c_str(), error.c_str());
+  }, intervalMs);
+}
+
+void UserModuleHost::unload(){
+  m_watcher.stop();
+
+  std::lock_guard<std::mutex> lock(m_loadMutex);
+  release(m_pending.exchange(nullptr, std::memory_order_acq_rel));
+  reclaim();
+  m_running.store(nullptr, std::memory_order_release);
+  release(m_current);
+  m_current = nullptr;
+}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "rt_file_watcher.h"
+#include "rt_module_abi.h"
+#include "rt_process_image.h"
+
+namespace Example{
+  // Loads user logic modules (rt_module_abi.h) and switches between them without stopping the tick.
+  // Loading, init, binding and warm-up happen in non-RT code; the tick picks up the new module at its
+  // start, hands over the state with migrate_state and runs it from then on. The previous module is
+  // unloaded by non-RT code once the tick has moved on.
+  class UserModuleHost
+  {
+    public:
+      ~UserModuleHost();
+
+      // Non-RT
+      bool load(const std::string& path, ProcessImage& image, std::string& error);
+      // Loads path whenever the file changes (it should be replaced by rename), polling every interval
+      void watch(const std::string& path, ProcessImage& image, uint32_t intervalMs = 500);
+      // Stops watching and unloads all modules, the tick must not run any more
+      void unload();
+      std::string activeName() const;
+
+      // RT side. With a predecessor, e.g. the active logic for a module in shadow mode, the new module
+      // takes over the state of the predecessor's module instead of its own previous one.
+      void switchModule(const UserModuleHost* predecessor = nullptr);
+      bool active() const { return m_current != nullptr; }
+      void AT(const uint8_t* inData) { m_current->api->AT(m_current->state, inData); }
+      void MDT(uint8_t* outData) { m_current->api->MDT(m_current->state, outData); }
+
+    private:
+      struct Module
+      {
+        void* handle = nullptr;
+        const ExampleModule* api = nullptr;
+        void* state = nullptr;
+        std::string name;
+      };
+
+      static void release(Module* module);
+      void reclaim();
+
+      std::mutex m_loadMutex;             // serializes loaders
+      uint64_t m_generation = 0;
+      std::atomic<Module*> m_pending{nullptr};  // loaded and warmed up, taken by the next tick
+      std::atomic<Module*> m_retired{nullptr};  // replaced by the tick, released by non-RT code
+      std::atomic<Module*> m_running{nullptr};  // published copy of m_current for non-RT code
+      Module* m_current = nullptr;              // RT
+
+      FileWatcher m_watcher;
+  };
+}
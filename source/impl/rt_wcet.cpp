@@ -0,0 +1,128 @@
+#include "rt_wcet.h"
+#include <algorithm>
+#include <ctime>
+
+namespace Example{
+namespace {
+  constexpr size_t CACHE_LINE = 64;
+  const char* const PHASE_NAMES[WCET_PHASES] = {"prepare", "inputs", "AT", "sequences", "MDT", "outputs", "finish", "tick"};
+}
+
+const char* wcetPhaseName(WcetPhase phase){
+  return PHASE_NAMES[static_cast<size_t>(phase)];
+}
+
+uint64_t WcetProbe::now(){
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return uint64_t(time.tv_sec)*1000000000 + time.tv_nsec;
+}
+
+void WcetProbe::enable(uint32_t coldEvery, size_t evictBytes, size_t samples){
+  m_enabled = false;
+  m_coldEvery = coldEvery ? coldEvery : 1;
+  // touched once here, so the eviction does not page fault in the tick
+  m_evict.assign(std::max(evictBytes, CACHE_LINE), 0);
+  for(size_t phase = 0; phase < WCET_PHASES; phase++){
+    m_coldSamples[phase].values.assign(std::max<size_t>(samples, 1), 0);
+    m_warmSamples[phase].values.assign(std::max<size_t>(samples, 1), 0);
+  }
+  reset();
+  m_enabled = true;
+}
+
+void WcetProbe::disable(){
+  m_enabled = false;
+  m_cold = false;
+  m_evict.clear();
+  m_evict.shrink_to_fit();
+}
+
+void WcetProbe::reset(){
+  m_ticks = 0;
+  for(size_t phase = 0; phase < WCET_PHASES; phase++){
+    m_coldSamples[phase].count = 0;
+    m_coldSamples[phase].max = 0;
+    m_warmSamples[phase].count = 0;
+    m_warmSamples[phase].max = 0;
+  }
+}
+
+void WcetProbe::enableCounters(uint32_t windowTicks){
+  m_counting = false;
+  m_windowTicks = windowTicks ? windowTicks : 1;
+  m_counterState = CounterState::Requested;
+  m_countTick = false;
+  m_window = CounterWindow{};
+  m_counting = true;
+}
+
+void WcetProbe::disableCounters(){
+  m_counting = false;
+  m_countTick = false;
+  m_counters.close();
+}
+
+void WcetProbe::beginCount(){
+  if(m_counterState == CounterState::Requested){
+    // perf_event_open counts the calling thread, so it has to be called here once
+    m_counterState = m_counters.open() ? CounterState::Open : CounterState::TimingOnly;
+    m_countTick = false;
+    return;
+  }
+  m_countTick = !m_cold;
+  if(m_countTick && m_counterState == CounterState::Open && !m_counters.read(m_beginCounts))
+    m_counterState = CounterState::TimingOnly;
+  std::copy(m_beginCounts, m_beginCounts + PERF_COUNTERS, m_lastCounts);
+}
+
+void WcetProbe::count(WcetPhase phase, uint64_t duration){
+  PhaseCounts& counts = m_window.phases[static_cast<size_t>(phase)];
+  counts.nanoseconds += duration;
+  if(m_counterState != CounterState::Open)
+    return;
+  uint64_t values[PERF_COUNTERS];
+  if(!m_counters.read(values))
+    return;
+  for(size_t counter = 0; counter < PERF_COUNTERS; counter++){
+    counts.counts[counter] += values[counter] - m_lastCounts[counter];
+    m_lastCounts[counter] = values[counter];
+  }
+}
+
+bool WcetProbe::endCount(uint64_t duration){
+  PhaseCounts& tick = m_window.phases[static_cast<size_t>(WcetPhase::Tick)];
+  tick.nanoseconds += duration;
+  if(m_counterState == CounterState::Open){
+    for(size_t counter = 0; counter < PERF_COUNTERS; counter++)
+      tick.counts[counter] += m_lastCounts[counter] - m_beginCounts[counter];
+  }
+  if(++m_window.ticks < m_windowTicks)
+    return false;
+  m_window.sequence = m_sequence++;
+  m_window.counters = m_counterState == CounterState::Open;
+  if(!m_windows.push(m_window))
+    m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  m_window = CounterWindow{};
+  return true;
+}
+
+void WcetProbe::evict(){
+  // a write per line leaves every line of the buffer dirty in the cache hierarchy and every page in the TLB
+  volatile uint8_t* line = m_evict.data();
+  for(size_t offset = 0; offset < m_evict.size(); offset += CACHE_LINE)
+    line[offset] = static_cast<uint8_t>(line[offset] + 1);
+}
+
+std::vector<WcetStatistics> WcetProbe::statistics(bool cold) const{
+  std::vector<WcetStatistics> result;
+  for(size_t phase = 0; phase < WCET_PHASES; phase++){
+    const Samples& samples = (cold ? m_coldSamples : m_warmSamples)[phase];
+    std::vector<uint32_t> sorted(samples.values.begin(), samples.values.begin() + std::min(samples.count, samples.values.size()));
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p){ return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(p*sorted.size()))]; };
+    result.push_back(WcetStatistics{PHASE_NAMES[phase], sorted.size(), percentile(0.5), percentile(0.99), percentile(0.999), samples.max});
+  }
+  return result;
+}
+}
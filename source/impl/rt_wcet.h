@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "rt_perf_counters.h"
+#include "rt_spsc_queue.h"
+
+namespace Example{
+  // Sections of RTApplication::execute timed by the WCET measurement
+  enum class WcetPhase : uint8_t
+  {
+    Prepare,   // module switch, parameters, commands
+    Inputs,    // readInputs
+    AT,        // analog inputs, AT, telemetry, input scope
+    Sequences,
+    MDT,       // MDT, diagram, analog outputs, timer wheel, published realtime data
+    Outputs,   // output scope, writeOutputs
+    Finish,    // export, retained state, background work
+    Tick       // whole tick
+  };
+  constexpr size_t WCET_PHASES = 8;
+  const char* wcetPhaseName(WcetPhase phase);
+
+  // Distribution of the time of one phase, ns
+  struct WcetStatistics
+  {
+    const char* phase;
+    size_t samples;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+  };
+
+  // Sums of one phase over the ticks of a counter window
+  struct PhaseCounts
+  {
+    uint64_t nanoseconds;
+    uint64_t counts[PERF_COUNTERS];
+  };
+
+  // Time and hardware counters of the tick phases over a window of ticks, handed to non-RT code
+  struct CounterWindow
+  {
+    uint64_t sequence;
+    uint32_t ticks;
+    bool counters; // false: timing only, the counts are zero
+    PhaseCounts phases[WCET_PHASES];
+  };
+
+  // Measurement of the worst-case execution time of the tick. Every N-th tick is run cold: caches and TLB
+  // are evicted first by streaming through a buffer larger than the last level cache, one access per
+  // line, so the tick finds neither its data nor its page translations. Cold and warm times are kept per
+  // phase. Meant for commissioning and host runs: a cold tick takes as long as the eviction in addition.
+  // Independently, the probe sums time and hardware counters (cycles, instructions, cache and branch misses)
+  // per phase over windows of warm ticks, which tells whether a slower tick misses the cache or computes
+  // more. The counters are opened on the RT thread in the first tick after enableCounters(), that tick is
+  // not counted; without counters the windows hold the times only.
+  class WcetProbe
+  {
+    public:
+      // Non-RT; the samples are kept in preallocated rings of the given size per phase
+      void enable(uint32_t coldEvery, size_t evictBytes = 64u << 20, size_t samples = 1u << 16);
+      void disable();
+      bool enabled() const { return m_enabled; }
+      // Non-RT, while the tick does not run
+      std::vector<WcetStatistics> statistics(bool cold) const;
+      void reset();
+      // Non-RT; windows of the given number of ticks
+      void enableCounters(uint32_t windowTicks);
+      // Non-RT, while the tick does not run
+      void disableCounters();
+      bool countersEnabled() const { return m_counting; }
+      bool poll(CounterWindow& window) { return m_windows.pop(window); }
+      uint64_t droppedWindows() const { return m_dropped.load(std::memory_order_relaxed); }
+
+      // RT side, a no-op while disabled
+      void beginTick(){
+        if(!m_enabled && !m_counting)
+          return;
+        if(m_enabled){
+          m_cold = ++m_ticks % m_coldEvery == 0;
+          if(m_cold)
+            evict();
+        }
+        if(m_counting)
+          beginCount();
+        m_begin = m_last = now();
+      }
+      void mark(WcetPhase phase){
+        if(!m_enabled && !m_counting)
+          return;
+        uint64_t time = now();
+        if(m_enabled)
+          record(phase, time - m_last);
+        if(m_countTick)
+          count(phase, time - m_last);
+        m_last = time;
+      }
+      // True when a counter window was completed
+      bool endTick(){
+        if(!m_enabled && !m_counting)
+          return false;
+        uint64_t duration = now() - m_begin;
+        if(m_enabled)
+          record(WcetPhase::Tick, duration);
+        return m_countTick && endCount(duration);
+      }
+
+    private:
+      struct Samples
+      {
+        std::vector<uint32_t> values;
+        size_t count = 0; // recorded in total, the ring keeps the newest
+        uint32_t max = 0; // over all recorded
+      };
+
+      enum class CounterState : uint8_t
+      {
+        Requested, // opened by the next tick
+        Open,
+        TimingOnly
+      };
+
+      static uint64_t now();
+      void evict();
+      void beginCount();
+      void count(WcetPhase phase, uint64_t duration);
+      bool endCount(uint64_t duration);
+      void record(WcetPhase phase, uint64_t duration){
+        Samples& samples = (m_cold ? m_coldSamples : m_warmSamples)[static_cast<size_t>(phase)];
+        auto value = static_cast<uint32_t>(std::min<uint64_t>(duration, UINT32_MAX));
+        samples.values[samples.count++ % samples.values.size()] = value;
+        samples.max = std::max(samples.max, value);
+      }
+
+      bool m_enabled = false;
+      bool m_cold = false;
+      uint32_t m_coldEvery = 1;
+      uint64_t m_ticks = 0;
+      uint64_t m_begin = 0;
+      uint64_t m_last = 0;
+      std::vector<uint8_t> m_evict;
+      Samples m_coldSamples[WCET_PHASES];
+      Samples m_warmSamples[WCET_PHASES];
+
+      bool m_counting = false;
+      bool m_countTick = false;
+      CounterState m_counterState = CounterState::Requested;
+      uint32_t m_windowTicks = 1000;
+      uint64_t m_sequence = 0;
+      std::atomic<uint64_t> m_dropped{0};
+      uint64_t m_beginCounts[PERF_COUNTERS] = {};
+      uint64_t m_lastCounts[PERF_COUNTERS] = {};
+      PerfCounters m_counters;
+      CounterWindow m_window{};
+      SpscQueue<CounterWindow, 16> m_windows;
+  };
+}
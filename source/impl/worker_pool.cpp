@@ -0,0 +1,262 @@
+#include "worker_pool.h"
+#include "Logger.h"
+#include "rt_timeline.h"
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <unistd.h>
+#include <algorithm>
+
+namespace Example{
+namespace {
+  // idle workers look for RT handoffs at this period, the RT side never wakes them
+  constexpr auto POLL_PERIOD = std::chrono::milliseconds(1);
+  // number of handoffs a worker moves from the inbox into its own deque at once
+  constexpr size_t INBOX_BATCH = 16;
+
+  thread_local size_t t_workerIndex = SIZE_MAX;
+  thread_local const void* t_workerPool = nullptr;
+
+  std::string readFirstLine(const char* path){
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+  }
+}
+
+WorkerPool::~WorkerPool(){
+  stop();
+}
+
+bool WorkerPool::start(const std::vector<int>& cores){
+  if(running())
+    return true;
+
+  auto isolated = parseCores(readFirstLine("/sys/devices/system/cpu/isolated"));
+  std::vector<int> selected;
+  for(int core : cores.empty() ? housekeepingCores() : cores){
+    if(std::find(isolated.begin(), isolated.end(), core) != isolated.end()){
+      LOG_WARNING("Core %i is isolated for real-time use, no worker is started on it", core);
+      continue;
+    }
+    selected.push_back(core);
+  }
+  // an unpinned worker could run on an isolated core, without usable cores the pool does not start
+  if(selected.empty() && !cores.empty()){
+    LOG_WARNING("None of the selected cores can take a worker, the workers run on the cores not isolated");
+    selected = housekeepingCores();
+  }
+  if(selected.empty()){
+    LOG_ERROR("All cores are isolated for real-time use, no worker is started");
+    return false;
+  }
+
+  m_running.store(true, std::memory_order_release);
+  for(int core : selected){
+    auto worker = std::make_unique<Worker>();
+    worker->core = core;
+    m_workers.push_back(std::move(worker));
+  }
+  for(size_t index = 0; index < m_workers.size(); index++)
+    m_workers[index]->thread = std::thread(&WorkerPool::run, this, index);
+
+  // the workers report once they are on their core
+  bool pinned = true;
+  {
+    std::unique_lock<std::mutex> guard(m_waitLock);
+    for(auto& worker : m_workers){
+      m_wake.wait(guard, [&]{ return worker->started != 0; });
+      if(worker->started < 0){
+        LOG_ERROR("Failed to pin a worker to core %i", worker->core);
+        pinned = false;
+      }
+    }
+  }
+  if(!pinned){
+    stop();
+    return false;
+  }
+  LOG_INFO("Worker pool started with %zu threads", m_workers.size());
+  return true;
+}
+
+void WorkerPool::stop(){
+  if(!running())
+    return;
+  {
+    std::lock_guard<std::mutex> guard(m_waitLock);
+    m_running.store(false, std::memory_order_release);
+  }
+  m_wake.notify_all();
+  for(auto& worker : m_workers){
+    if(worker->thread.joinable())
+      worker->thread.join();
+  }
+  m_workers.clear();
+  // handoffs still queued are discarded, the RT side is no longer running at this point
+  WorkItem item;
+  while(m_inbox.pop(item)){}
+  m_pending.store(0, std::memory_order_release);
+}
+
+void WorkerPool::drain(){
+  while(running() && m_pending.load(std::memory_order_acquire) != 0)
+    std::this_thread::sleep_for(POLL_PERIOD);
+}
+
+bool WorkerPool::post(const WorkItem& item){
+  m_pending.fetch_add(1, std::memory_order_relaxed);
+  if(!m_inbox.push(item)){
+    m_pending.fetch_sub(1, std::memory_order_relaxed);
+    m_rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+bool WorkerPool::submit(const WorkItem& item){
+  if(!running() || m_workers.empty())
+    return false;
+  // work created by a worker stays on its own deque, everything else is distributed round robin
+  size_t index = t_workerPool == this ? t_workerIndex : m_next.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+  m_pending.fetch_add(1, std::memory_order_relaxed);
+  if(!pushLocal(*m_workers[index], item)){
+    m_pending.fetch_sub(1, std::memory_order_relaxed);
+    m_rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  m_wake.notify_one();
+  return true;
+}
+
+bool WorkerPool::pushLocal(Worker& worker, const WorkItem& item){
+  std::lock_guard<std::mutex> guard(worker.lock);
+  if(worker.count == DEQUE_CAPACITY)
+    return false;
+  worker.items[(worker.head + worker.count) % DEQUE_CAPACITY] = item;
+  worker.count++;
+  return true;
+}
+
+bool WorkerPool::popLocal(Worker& worker, WorkItem& item){
+  // the owner works LIFO on the back of its deque
+  std::lock_guard<std::mutex> guard(worker.lock);
+  if(worker.count == 0)
+    return false;
+  worker.count--;
+  item = worker.items[(worker.head + worker.count) % DEQUE_CAPACITY];
+  return true;
+}
+
+bool WorkerPool::steal(size_t thief, WorkItem& item){
+  // thieves take the oldest item from the front of a victim's deque and never wait for a busy victim
+  for(size_t offset = 1; offset < m_workers.size(); offset++){
+    auto& victim = *m_workers[(thief + offset) % m_workers.size()];
+    std::unique_lock<std::mutex> guard(victim.lock, std::try_to_lock);
+    if(!guard.owns_lock() || victim.count == 0)
+      continue;
+    item = victim.items[victim.head];
+    victim.head = (victim.head + 1) % DEQUE_CAPACITY;
+    victim.count--;
+    m_stolen.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+bool WorkerPool::drainInbox(Worker& worker){
+  std::unique_lock<std::mutex> guard(m_inboxLock, std::try_to_lock);
+  if(!guard.owns_lock())
+    return false;
+  size_t moved = 0;
+  WorkItem item;
+  while(moved < INBOX_BATCH && m_inbox.pop(item)){
+    if(!pushLocal(worker, item)){
+      execute(item); // own deque is full, run it directly rather than dropping it
+    }
+    moved++;
+  }
+  if(moved > 1)
+    m_wake.notify_all();
+  return moved != 0;
+}
+
+void WorkerPool::execute(const WorkItem& item){
+  if(item.function){
+    TimelineScope scope("work item");
+    item.function(item.context, item.argument);
+  }
+  m_executed.fetch_add(1, std::memory_order_relaxed);
+  m_pending.fetch_sub(1, std::memory_order_release);
+}
+
+void WorkerPool::run(size_t index){
+  auto& worker = *m_workers[index];
+  // the thread inherits the mask of the caller, possibly an isolated core; nothing runs before it is moved
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(worker.core, &set);
+  int pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  {
+    std::lock_guard<std::mutex> guard(m_waitLock);
+    worker.started = pinned == 0 ? 1 : -1;
+  }
+  m_wake.notify_all();
+  if(pinned != 0)
+    return;
+  pthread_setname_np(pthread_self(), ("example-work" + std::to_string(index)).c_str());
+  t_workerIndex = index;
+  t_workerPool = this;
+  WorkItem item;
+  while(running()){
+    if(popLocal(worker, item) || steal(index, item)){
+      execute(item);
+      continue;
+    }
+    if(drainInbox(worker))
+      continue;
+    std::unique_lock<std::mutex> guard(m_waitLock);
+    if(running())
+      m_wake.wait_for(guard, POLL_PERIOD);
+  }
+  t_workerPool = nullptr;
+}
+
+std::vector<int> WorkerPool::parseCores(const std::string& list){
+  std::vector<int> cores;
+  std::stringstream stream(list);
+  std::string range;
+  while(std::getline(stream, range, ',')){
+    if(range.empty())
+      continue;
+    auto dash = range.find('-');
+    try{
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for(int core = first; core <= last; core++)
+        cores.push_back(core);
+    }
+    catch(const std::exception&){
+      LOG_WARNING("Ignoring invalid core range '%s'", range.c_str());
+    }
+  }
+  return cores;
+}
+
+std::vector<int> WorkerPool::housekeepingCores(){
+  auto isolated = parseCores(readFirstLine("/sys/devices/system/cpu/isolated"));
+  auto online = parseCores(readFirstLine("/sys/devices/system/cpu/online"));
+  if(online.empty()){
+    for(long core = 0; core < sysconf(_SC_NPROCESSORS_ONLN); core++)
+      online.push_back(static_cast<int>(core));
+  }
+  std::vector<int> cores;
+  for(int core : online){
+    if(std::find(isolated.begin(), isolated.end(), core) == isolated.end())
+      cores.push_back(core);
+  }
+  return cores;
+}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rt_spsc_queue.h"
+
+namespace Example{
+  // Unit of background work. Plain data so it can be handed over from the RT tick without allocation.
+  struct WorkItem
+  {
+    void (*function)(void* context, uint64_t argument) = nullptr;
+    void* context = nullptr;
+    uint64_t argument = 0;
+  };
+
+  // Non-RT worker threads pinned to housekeeping cores.
+  // Every worker owns a bounded deque and steals from the others when it runs dry.
+  // The RT tick hands work over through post(), which never blocks and fails when the inbox is full.
+  // Items run concurrently and in no particular order.
+  class WorkerPool
+  {
+    public:
+      static constexpr size_t DEQUE_CAPACITY = 256;
+      static constexpr size_t INBOX_CAPACITY = 256;
+
+      ~WorkerPool();
+
+      // Lifecycle, non-RT. An empty core list selects all online cores that are not isolated.
+      // Each worker pins itself before it does anything else; false, with no worker running, if that fails
+      // or if every core is isolated.
+      bool start(const std::vector<int>& cores = {});
+      void stop();
+      bool running() const { return m_running.load(std::memory_order_acquire); }
+      // Waits until every item accepted so far has run, e.g. before the state the items use is freed.
+      // Not from a worker; items posted concurrently may extend the wait.
+      void drain();
+
+      // RT side
+      bool post(const WorkItem& item);
+
+      // Non-RT side
+      bool submit(const WorkItem& item);
+
+      uint64_t executed() const { return m_executed.load(std::memory_order_relaxed); }
+      uint64_t stolen() const { return m_stolen.load(std::memory_order_relaxed); }
+      uint64_t rejected() const { return m_rejected.load(std::memory_order_relaxed); }
+
+      // Core list helpers, e.g. "0-1,3"
+      static std::vector<int> parseCores(const std::string& list);
+      static std::vector<int> housekeepingCores();
+
+    private:
+      struct Worker
+      {
+        std::mutex lock;
+        WorkItem items[DEQUE_CAPACITY];
+        size_t head = 0;
+        size_t count = 0;
+        int core = 0;
+        int started = 0; // guarded by m_waitLock: 1 running on its core, -1 not pinned
+        std::thread thread;
+      };
+
+      void run(size_t index);
+      bool pushLocal(Worker& worker, const WorkItem& item);
+      bool popLocal(Worker& worker, WorkItem& item);
+      bool steal(size_t thief, WorkItem& item);
+      bool drainInbox(Worker& worker);
+      void execute(const WorkItem& item);
+
+      std::vector<std::unique_ptr<Worker>> m_workers;
+      std::atomic<bool> m_running{false};
+      std::atomic<size_t> m_next{0};
+      std::mutex m_waitLock;
+      std::condition_variable m_wake;
+
+      // the RT side is the only producer, the workers take turns as consumer
+      SpscQueue<WorkItem, INBOX_CAPACITY> m_inbox;
+      std::mutex m_inboxLock;
+
+      std::atomic<uint64_t> m_pending{0}; // accepted, not yet executed
+      std::atomic<uint64_t> m_executed{0};
+      std::atomic<uint64_t> m_stolen{0};
+      std::atomic<uint64_t> m_rejected{0};
+  };
+}
@@ -0,0 +1,119 @@
+//
+// Example user logic module
+//
+// The drive handling of User/EtherCATUpdates.cpp as a module that can be replaced while the RT task runs,
+// see rt_module_abi.h. Build it, then copy it to $SNAP_COMMON/logic.so (or SDK_EXAMPLE_MODULE) with
+// a rename so the host never sees a partly written file.
+//
+#include "rt_module_abi.h"
+#include <cstring>
+
+namespace {
+  //control word constants
+  const uint16_t CMD_DriveON = 0x8000;
+  const uint16_t CMD_DriveEnable = 0x4000;
+  const uint16_t CMD_DriveHALT = 0x2000;
+  const uint16_t CMD_CommsToggle = 0x0400;
+  const uint16_t CMD_ClearOpMode = 0xF4FF;
+  const uint16_t CMD_SecondaryOpMode = 0x0100;
+  //status word constants
+  const uint16_t ST_DriveInAb = 0x8000;
+  const uint16_t ST_DriveError = 0x2000;
+
+  //all state lives here, the host allocates it and hands it over to the next version
+  struct State
+  {
+    //version 1
+    uint32_t DigitalOutputs;
+    uint32_t ControlWord;
+    uint32_t VelocityCommand;
+    uint32_t StatusWord;
+    uint32_t ActPosition;
+    uint64_t Ticks;
+    uint16_t OutputPattern;
+    uint16_t Control;
+    uint16_t Status;
+    int32_t Position;
+    int32_t Velocity;
+  };
+  const uint32_t STATE_VERSION = 1;
+
+  int resolve(int (*lookup)(void*, const char*, uint32_t*, uint32_t*), void* context, const char* name, uint32_t& byteOffset){
+    uint32_t bitOffset, bitSize;
+    if(lookup(context, name, &bitOffset, &bitSize) != 0)
+      return -1;
+    byteOffset = bitOffset/8;
+    return 0;
+  }
+
+  int init(void* memory, const ExampleModuleImage* image){
+    auto state = static_cast<State*>(memory);
+    if(resolve(image->output, image->context, "DO_16_1/Channel_1.Value", state->DigitalOutputs) != 0 ||
+       resolve(image->output, image->context, "Axis1/MDT.Master_control_word", state->ControlWord) != 0 ||
+       resolve(image->output, image->context, "Axis1/MDT.VelocityCommand", state->VelocityCommand) != 0 ||
+       resolve(image->input, image->context, "Axis1/AT.Drive_status_word", state->StatusWord) != 0 ||
+       resolve(image->input, image->context, "Axis1/AT.Position_feedback_value_1", state->ActPosition) != 0)
+      return -1;
+    state->OutputPattern = 0xFF;
+    state->Control = 0x0100;
+    state->Velocity = 300000;
+    return 0;
+  }
+
+  void AT(void* memory, const uint8_t* inData){
+    auto state = static_cast<State*>(memory);
+    std::memcpy(&state->Status, &inData[state->StatusWord], 2);
+    std::memcpy(&state->Position, &inData[state->ActPosition], 4);
+  }
+
+  void MDT(void* memory, uint8_t* outData){
+    auto state = static_cast<State*>(memory);
+    state->Ticks++;
+    if(0 == state->Ticks%500)
+    {
+        state->OutputPattern = state->OutputPattern ^ 0xFFFF;
+    }
+    if(((state->Status & ST_DriveInAb) != 0) && ((state->Status & ST_DriveError) == 0))
+    {
+        state->Control = state->Control | (CMD_DriveEnable | CMD_DriveHALT | CMD_DriveON);
+        state->Control = (state->Control & CMD_ClearOpMode) | CMD_SecondaryOpMode;
+    }
+    else
+    {
+        state->Control = state->Control & 0x1FFF;
+    }
+    state->Control = state->Control ^ CMD_CommsToggle;
+    std::memcpy(&outData[state->DigitalOutputs], &state->OutputPattern, 2);
+    std::memcpy(&outData[state->ControlWord], &state->Control, 2);
+    std::memcpy(&outData[state->VelocityCommand], &state->Velocity, 4);
+  }
+
+  //keep the tick counter, the output pattern and the toggle bit of the control word, so the drive
+  //sees no interruption; the offsets resolved in init are kept
+  void migrate_state(void* memory, const void* previous, uint32_t previousVersion, uint32_t previousSize){
+    auto state = static_cast<State*>(memory);
+    if(previousVersion != STATE_VERSION || previousSize < sizeof(State))
+      return;
+    auto old = static_cast<const State*>(previous);
+    state->Ticks = old->Ticks;
+    state->OutputPattern = old->OutputPattern;
+    state->Control = old->Control;
+    state->Status = old->Status;
+    state->Position = old->Position;
+  }
+
+  const ExampleModule MODULE = {
+    EXAMPLE_MODULE_ABI_VERSION,
+    STATE_VERSION,
+    sizeof(State),
+    "example-logic",
+    init,
+    AT,
+    MDT,
+    migrate_state,
+  };
+}
+
+extern "C" __attribute__((visibility("default"))) const ExampleModule* example_module(void){
+  return &MODULE;
+}
@@ -0,0 +1,76 @@
+//
+// Image monitor
+//
+// Prints the exported values and selected image variables of the running RT application, e.g.
+//   image_monitor --interval 100 Axis1/AT.Drive_status_word
+// Uses the reader library only, it does not affect the timing of the tick.
+//
+#include "image_reader.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  uint64_t readVariable(const Example::ImageSnapshot& snapshot, const Example::ExportVariable& variable){
+    uint64_t value = 0;
+    const uint8_t* data = snapshot.data(variable);
+    if(variable.bitSize < 8)
+      return (data[0] >> (variable.bitOffset % 8)) & ((1u << variable.bitSize) - 1);
+    std::memcpy(&value, data, std::min<uint32_t>(variable.bitSize/8, sizeof(value)));
+    return value;
+  }
+}
+
+int main(int argc, char** argv){
+  std::string segment = Example::EXPORT_DEFAULT_NAME;
+  int intervalMs = 500;
+  std::vector<std::string> names;
+  for(int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    if(arg == "--segment" && i + 1 < argc)
+      segment = argv[++i];
+    else if(arg == "--interval" && i + 1 < argc)
+      intervalMs = std::stoi(argv[++i]);
+    else
+      names.push_back(arg);
+  }
+
+  Example::ImageReader reader;
+  std::vector<const Example::ExportVariable*> variables;
+  while(true){
+    if(reader.closed()){
+      std::string error;
+      if(!reader.open(segment, &error)){
+        std::fprintf(stderr, "%s, retrying\n", error.c_str());
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        continue;
+      }
+      variables.clear();
+      for(auto& name : names){
+        variables.push_back(reader.variable(name));
+        if(!variables.back())
+          std::fprintf(stderr, "%s: no such variable\n", name.c_str());
+      }
+    }
+
+    Example::ImageSnapshot snapshot;
+    if(reader.latest(snapshot)){
+      std::string line = "tick " + std::to_string(snapshot.tick);
+      for(uint32_t i = 0; i < reader.valueCount(); i++)
+        line += std::string("  ") + reader.valueName(i) + "=" + std::to_string(snapshot.values[i]);
+      for(size_t i = 0; i < variables.size(); i++)
+        if(variables[i])
+          line += "  " + names[i] + "=" + std::to_string(readVariable(snapshot, *variables[i]));
+      if(snapshot.valid()){
+        std::printf("%s\n", line.c_str());
+        std::fflush(stdout);
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+  }
+}
@@ -0,0 +1,134 @@
+#include "image_reader.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Example{
+namespace {
+  // the writer laps a reader that is preempted for more than EXPORT_SLOTS - 1 ticks, it starts over then
+  constexpr int RETRIES = 16;
+
+  bool fail(std::string* error, const std::string& text){
+    if(error)
+      *error = text;
+    return false;
+  }
+}
+
+ImageReader::~ImageReader(){
+  close();
+}
+
+bool ImageReader::open(const std::string& name, std::string* error){
+  close();
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if(fd < 0)
+    return fail(error, name + ": " + strerror(errno));
+  struct stat status;
+  void* memory = MAP_FAILED;
+  if(fstat(fd, &status) == 0 && size_t(status.st_size) >= sizeof(ExportHeader))
+    memory = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(memory == MAP_FAILED)
+    return fail(error, name + ": not mapped");
+
+  auto base = static_cast<const uint8_t*>(memory);
+  auto header = reinterpret_cast<const ExportHeader*>(base);
+  if(header->magic.load(std::memory_order_acquire) != EXPORT_MAGIC || header->layoutVersion != EXPORT_LAYOUT_VERSION ||
+     header->slotsOffset + uint64_t(header->slotCount)*header->slotSize > uint64_t(status.st_size)){
+    munmap(memory, status.st_size);
+    return fail(error, name + ": no export of layout version " + std::to_string(EXPORT_LAYOUT_VERSION));
+  }
+  m_memory = memory;
+  m_size = status.st_size;
+  m_header = header;
+  m_variables = reinterpret_cast<const ExportVariable*>(base + header->variablesOffset);
+  m_values = reinterpret_cast<const ExportValue*>(base + header->valuesOffset);
+  m_slots = base + header->slotsOffset;
+  return true;
+}
+
+void ImageReader::close(){
+  if(m_memory)
+    munmap(const_cast<void*>(m_memory), m_size);
+  m_memory = nullptr;
+  m_size = 0;
+  m_header = nullptr;
+  m_variables = nullptr;
+  m_values = nullptr;
+  m_slots = nullptr;
+}
+
+bool ImageReader::closed() const{
+  return !m_header || m_header->magic.load(std::memory_order_acquire) != EXPORT_MAGIC;
+}
+
+uint64_t ImageReader::published() const{
+  return m_header ? m_header->published.load(std::memory_order_acquire) : 0;
+}
+
+bool ImageReader::latest(ImageSnapshot& snapshot) const{
+  if(closed())
+    return false;
+  for(int attempt = 0; attempt < RETRIES; attempt++){
+    uint64_t published = m_header->published.load(std::memory_order_acquire);
+    if(published == 0)
+      return false;
+    const uint8_t* slotBase = m_slots + ((published - 1) % m_header->slotCount)*m_header->slotSize;
+    auto slot = reinterpret_cast<const ExportSlot*>(slotBase);
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if(sequence != 2*published)
+      continue;
+    snapshot.tick = slot->tick;
+    snapshot.timestamp = slot->timestamp;
+    snapshot.inputs = slotBase + sizeof(ExportSlot);
+    snapshot.outputs = snapshot.inputs + m_header->inputSize;
+    snapshot.values = reinterpret_cast<const double*>(slotBase + m_header->slotValuesOffset);
+    snapshot.sequence = &slot->sequence;
+    snapshot.expected = sequence;
+    if(snapshot.valid())
+      return true;
+  }
+  return false;
+}
+
+bool ImageReader::copy(std::vector<uint8_t>& inputs, std::vector<uint8_t>& outputs, std::vector<double>& values,
+                       uint64_t* tick) const{
+  if(!m_header)
+    return false;
+  inputs.resize(m_header->inputSize);
+  outputs.resize(m_header->outputSize);
+  values.resize(m_header->valueCount);
+  for(int attempt = 0; attempt < RETRIES; attempt++){
+    ImageSnapshot snapshot;
+    if(!latest(snapshot))
+      return false;
+    std::memcpy(inputs.data(), snapshot.inputs, inputs.size());
+    std::memcpy(outputs.data(), snapshot.outputs, outputs.size());
+    std::memcpy(values.data(), snapshot.values, values.size()*sizeof(double));
+    if(snapshot.valid()){
+      if(tick)
+        *tick = snapshot.tick;
+      return true;
+    }
+  }
+  return false;
+}
+
+const ExportVariable* ImageReader::variable(const std::string& name) const{
+  for(uint32_t i = 0; m_header && i < m_header->variableCount; i++)
+    if(name == m_variables[i].name)
+      return &m_variables[i];
+  return nullptr;
+}
+
+int ImageReader::valueIndex(const std::string& name) const{
+  for(uint32_t i = 0; m_header && i < m_header->valueCount; i++)
+    if(name == m_values[i].name)
+      return i;
+  return -1;
+}
+}
@@ -0,0 +1,80 @@
+#pragma once
+//
+// Reader of the shared-memory export of the RT application (ImageExporter, rt_export_layout.h)
+//
+// The segment is mapped read only, readers never write to it and cannot delay the tick. A snapshot
+// points into the segment (zero copy); the application overwrites its slot EXPORT_SLOTS - 1 ticks later,
+// so results computed from a snapshot are only used if valid() still holds afterwards.
+//
+//   Example::ImageReader reader;
+//   Example::ImageSnapshot snapshot;
+//   if(reader.open() && reader.latest(snapshot)){
+//     double velocity = snapshot.values[reader.valueIndex("Axis1/ActVelocity")];
+//     if(snapshot.valid())
+//       ... use velocity
+//   }
+//
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "rt_export_layout.h"
+
+namespace Example{
+  struct ImageSnapshot
+  {
+    uint64_t tick = 0;
+    int64_t timestamp = 0;            // CLOCK_MONOTONIC, ns
+    const uint8_t* inputs = nullptr;
+    const uint8_t* outputs = nullptr;
+    const double* values = nullptr;
+
+    // False once the application started to overwrite the snapshot
+    bool valid() const{
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return sequence && sequence->load(std::memory_order_relaxed) == expected;
+    }
+    // First byte of a variable in its image
+    const uint8_t* data(const ExportVariable& variable) const{
+      return (variable.output ? outputs : inputs) + variable.bitOffset/8;
+    }
+
+    const std::atomic<uint64_t>* sequence = nullptr;
+    uint64_t expected = 0;
+  };
+
+  class ImageReader
+  {
+    public:
+      ~ImageReader();
+
+      bool open(const std::string& name = EXPORT_DEFAULT_NAME, std::string* error = nullptr);
+      void close();
+      bool isOpen() const { return m_header != nullptr; }
+      // The application unbound or restarted, open() the segment again
+      bool closed() const;
+
+      // Latest complete snapshot, in place; false if none was published yet or the segment is closed
+      bool latest(ImageSnapshot& snapshot) const;
+      // Consistent copy of the latest snapshot, retries while the application overwrites it
+      bool copy(std::vector<uint8_t>& inputs, std::vector<uint8_t>& outputs, std::vector<double>& values,
+                uint64_t* tick = nullptr) const;
+      // Number of snapshots published since the application bound
+      uint64_t published() const;
+
+      const ExportVariable* variable(const std::string& name) const;
+      int valueIndex(const std::string& name) const;
+      uint32_t valueCount() const { return m_header ? m_header->valueCount : 0; }
+      const char* valueName(uint32_t index) const { return m_values[index].name; }
+      uint32_t inputSize() const { return m_header ? m_header->inputSize : 0; }
+      uint32_t outputSize() const { return m_header ? m_header->outputSize : 0; }
+
+    private:
+      const void* m_memory = nullptr;
+      size_t m_size = 0;
+      const ExportHeader* m_header = nullptr;
+      const ExportVariable* m_variables = nullptr;
+      const ExportValue* m_values = nullptr;
+      const uint8_t* m_slots = nullptr;
+  };
+}